@@ -90,6 +90,8 @@ extern unsigned cursor;
 extern bool useBook;
 extern bool usePersonalBook;
 extern Cache cache;
+extern thread_local EvalCache evalCache;
+extern string cacheFile;
 
 
 
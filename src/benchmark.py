@@ -156,6 +156,17 @@ timeTotal = 0
 engine = chess.engine.SimpleEngine.popen_uci(sys.argv[1])
 
 
+# any further arguments are UCI options given as NAME=VALUE, for example to
+# compare the replacement policies of the cache:
+#   ./benchmark.py ./chess0 Hash=1 HashReplace=always
+options = {}
+for arg in sys.argv[2:]:
+    name, value = arg.split("=", 1)
+    options[name] = value
+if options:
+    engine.configure(options)
+
+
 # test each of the positions
 for fen in fen_positions:
     count = count + 1
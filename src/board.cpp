@@ -26,6 +26,7 @@
 #include <iomanip>
 #include <algorithm>
 #include <string>
+#include <string.h>
 #include "definitions.h"
 #include "functions.h"
 #include "extglobals.h"
@@ -114,6 +115,7 @@ void Board::initFromSquares(int input[64], unsigned char next, int fiftyM, int c
     blackPieces  = 0;
     occupiedSquares = 0;
     hashkey = 0;
+    pawnkey = 0;
 
 
     // populate all the initial bitboards
@@ -149,6 +151,7 @@ void Board::initFromSquares(int input[64], unsigned char next, int fiftyM, int c
         {
             whitePawns   = whitePawns   | BITSET[i];
             hashkey     ^= KEY.keys[i][WHITE_PAWN];         
+            pawnkey     ^= KEY.keys[i][WHITE_PAWN];
         }
         if (square[i] == BLACK_KING)   
         {
@@ -179,6 +182,7 @@ void Board::initFromSquares(int input[64], unsigned char next, int fiftyM, int c
         {
             blackPawns   = blackPawns   | BITSET[i];
             hashkey     ^= KEY.keys[i][BLACK_PAWN];         
+            pawnkey     ^= KEY.keys[i][BLACK_PAWN];
         }
     }
 
@@ -211,17 +215,15 @@ void Board::initFromSquares(int input[64], unsigned char next, int fiftyM, int c
     totalBlackPieces =  bitCnt(blackKnights) * KNIGHT_VALUE + bitCnt(blackBishops) * BISHOP_VALUE +
         bitCnt(blackRooks) * ROOK_VALUE + bitCnt(blackQueens) * QUEEN_VALUE;
     Material  = totalWhitePawns + totalWhitePieces - totalBlackPawns - totalBlackPieces;
+    materialkey = materialKey();
 
     endOfGame = 0;
     endOfSearch = 0;
 
 
-    // clear triangular array for storing principal variation (PV)
-    for (i = 0; i < MAX_PLY; i++) 
-    {
-        moveBufLen[i] = 0;
-        triangularLength[i] = 0;
-    }
+    // clear the move buffer and the search stack (principal variation, etc)
+    memset(moveBufLen, 0, sizeof(moveBufLen));
+    memset(ss, 0, sizeof(ss));
     nodes = 0;
 }
 
@@ -54,6 +54,73 @@ using namespace std;
 
 
 
+// Counters of the last search, shown with the 'stats' command.
+struct SearchStats
+{
+    uint64_t aspirationSearches;   // iterations searched with an aspiration window
+    uint64_t failHigh;             // re-searches after failing high at the root
+    uint64_t failLow;              // re-searches after failing low at the root
+    uint64_t mtdfSearches;         // null-window searches of the MTD(f) driver
+    uint64_t betaCutoffs;          // nodes of alphabetapvs that failed high
+    uint64_t firstMoveCutoffs;     // ... with the first legal move searched
+    uint64_t futilityPruned;       // quiet moves skipped by futility pruning
+    uint64_t razored;              // nodes dropped into qsearch by razoring
+    uint64_t qnodes;               // nodes searched by qsearch
+    uint64_t deltaPruned;          // captures skipped by delta pruning
+    uint64_t lateMovePruned;       // quiet moves skipped by late move pruning
+    uint64_t lmrReductions;        // moves searched with a reduced depth
+    uint64_t lmrResearches;        // ... searched again at full depth
+    uint64_t nullMoves;            // null move searches
+    uint64_t nullCutoffs;          // ... that failed high (and were verified)
+    uint64_t nullVerified;         // ... that failed high at verification depth
+    uint64_t nullRefuted;          // ... where the verification search failed low
+    uint64_t probCutNodes;         // nodes with captures to try for ProbCut
+    uint64_t probCutMoves;         // ... captures searched
+    uint64_t probCutoffs;          // ... nodes cut
+    uint64_t etcNodes;             // nodes whose children were looked up first
+    uint64_t etcCutoffs;           // ... cut by a child found in the cache
+    uint64_t iidSearches;          // PV nodes searched first at a reduced depth
+    uint64_t iidBestMoves;         // ... where the IID move stayed the best one
+};
+
+
+
+// What the legal move generator needs to know about the position, computed
+// once per node (see setLegalMasks):
+//  - king:     square of the king of the side to move
+//  - checkers: opponent pieces giving check
+//  - evasions: squares where a piece other than the king must move, i.e.
+//              the checker and the squares in between (all if not in check)
+//  - pinned:   own pieces that cannot leave the line to their king
+struct LegalMasks
+{
+    int      king;
+    Bitboard checkers;
+    Bitboard evasions;
+    Bitboard pinned;
+};
+
+
+
+// What the search keeps for each ply of the current line (see alphabetapvs):
+//  - move:       move being searched from this ply (empty for a null move)
+//  - staticEval: static evaluation of the node (not set when in check)
+//  - killers:    two latest quiet moves that failed high at this ply
+//  - pv:         best line found from this ply on, pvLength moves long
+//
+// The moves of each ply are kept in Board::moveBuffer, from moveBufLen[ply]
+// up to moveBufLen[ply+1].
+struct SearchStack
+{
+    Move move;
+    int  staticEval;
+    Move killers[2];
+    int  pvLength;
+    Move pv[MAX_PLY];
+};
+
+
+
 struct Board
 {
     Bitboard whiteKing, whiteQueens, whiteRooks, whiteBishops, whiteKnights, whitePawns;
@@ -66,6 +133,8 @@ struct Board
     int epSquare;                  // En-passant target square after double pawn move
     int fiftyMove;                 // Moves since the last pawn move or capture
     uint64_t hashkey;                   // Random 'almost' unique signature for current board position.
+    uint64_t pawnkey;              // Signature of the pawn structure only (used by the pawn cache)
+    unsigned int materialkey;      // Index of the material signature table (piece counts)
 
     // additional variables:
     int square[64];                // incrementally updated, this array is usefull if we want to
@@ -84,19 +153,19 @@ struct Board
 
     // storing moves
     Move moveBuffer[MAX_MOV_BUFF];      // all generated moves of the current search
-    unsigned int moveBufLen[MAX_PLY];   // this arrays keeps track of which moves belong to which ply
+    unsigned int moveBufLen[MAX_PLY + 2];   // this arrays keeps track of which moves belong to which ply
     int endOfGame;                 // index for board.gameLine
     int endOfSearch;               // index for board.gameLine
     GameLineRecord gameLine[MAX_GAME_LINE];
 
 
     // search variables:
-    int triangularLength[MAX_PLY];
-    Move triangularArray[MAX_PLY][MAX_PLY];
+    SearchStack ss[MAX_PLY + 2];   // one entry per ply of the current line
     Timer timer;
     uint64_t msStart, msStop;
     int searchDepth;
     int lastPVLength;
+    int rootMoves;                 // legal moves at the root of the search
     Move lastPV[MAX_PLY];
     unsigned int whiteHeuristics[64][64];
     unsigned int blackHeuristics[64][64];
@@ -107,12 +176,15 @@ struct Board
     uint64_t countdown;
     uint64_t maxTime; 
     bool timedout;
+    SearchStats stats;
+    int threadId;                  // 0 for the main search thread, > 0 for helpers
     bool ponder;
 
 
     void init();
     int eval();
     Move think();
+    int mtdf(int depth, int guess);
     int alphabetapvs(int ply, int depth, int alpha, int beta);
     int qsearch(int ply, int alpha, int beta);
     void displaySearchStats(int mode, int depth, int score);
@@ -121,8 +193,7 @@ struct Board
     void initFromSquares(int input[64], unsigned char next, int fiftyM, int castleW, int castleB, int epSq);
     void display();
     void rememberPV();
-    void selectmove(int &ply, int &i, int &depth, bool &followpv); 
-    void addCaptScore(int &ifirst, int &index);
+    void addCaptScore(int &ifirst, int &index, int minScore);
     int SEE(Move &move);
     Bitboard attacksTo(int &target);
     Bitboard revealNextAttacker(Bitboard &attackers, Bitboard &nonremoved, int &target, int &heading);
@@ -23,6 +23,15 @@
 // This file contains the functions to manipulate the cache data structure and
 // transposition tables.
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "definitions.h"
 #include "cache.h"
 
@@ -32,21 +41,294 @@ using namespace std;
 
 
 
+// ~Cache
+//
+// Release the memory allocated for the transposition table.
+Cache::~Cache()
+{
+    release();
+}
+
+
+
+// release
+//
+// Free the transposition table, or unmap it if it was mapped with mmap().
+void Cache::release()
+{
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+    else
+        free(table);
+
+    table       = nullptr;
+    mapping     = nullptr;
+    mappingSize = 0;
+}
+
+
+
+// resize
+//
+// Allocate a new transposition table of (at most) the given size in MB. The
+// number of buckets is rounded down to a power of two, so that a bucket can be
+// addressed by masking the hash key. The old table is only released once the
+// new one has been allocated successfully.
+//
+// Tables of 2 MB or more are backed by explicit huge pages when the system has
+// them reserved, or else by memory aligned to a huge page with a transparent
+// huge page hint; regular pages are the last resort. Huge pages save most of
+// the TLB misses of random probes on a large table.
+bool Cache::resize(uint64_t mb)
+{
+    uint64_t n = 1, bytes;
+    ttBucket *newTable = nullptr;
+    void *newMapping = MAP_FAILED;
+    cacheBacking newBacking = CACHE_BACKING_PAGES;
+
+
+    // keep the size within sane limits
+    if (mb < CACHE_MIN_SIZE)
+        mb = CACHE_MIN_SIZE;
+    if (mb > CACHE_MAX_SIZE)
+        mb = CACHE_MAX_SIZE;
+
+
+    // find the largest power of two number of buckets that fits
+    while ((n * 2 * sizeof(ttBucket)) <= (mb * 1024 * 1024))
+        n *= 2;
+
+
+    bytes = n * sizeof(ttBucket);
+
+
+    // 1. explicit huge pages
+#ifdef MAP_HUGETLB
+    if (bytes >= HUGE_PAGE_SIZE)
+    {
+        newMapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (newMapping != MAP_FAILED)
+        {
+            newTable   = (ttBucket *) newMapping;
+            newBacking = CACHE_BACKING_HUGETLB;
+        }
+    }
+#endif
+
+
+    // 2. transparent huge pages
+    if ((newTable == nullptr) && (bytes >= HUGE_PAGE_SIZE))
+    {
+        newTable = (ttBucket *) aligned_alloc(HUGE_PAGE_SIZE, bytes);
+#ifdef MADV_HUGEPAGE
+        if ((newTable != nullptr) && (madvise(newTable, bytes, MADV_HUGEPAGE) == 0))
+            newBacking = CACHE_BACKING_THP;
+#endif
+    }
+
+
+    // 3. regular pages, aligned to the cache line
+    if (newTable == nullptr)
+        newTable = (ttBucket *) aligned_alloc(sizeof(ttBucket), bytes);
+
+    if (newTable == nullptr)
+    {
+        cerr << "Cannot allocate " << mb << " MB for the cache!" << endl;
+        return false;
+    }
+
+    release();
+    table   = newTable;
+    buckets = n;
+    mask    = n - 1;
+    backing = newBacking;
+    if (newMapping != MAP_FAILED)
+    {
+        mapping     = newMapping;
+        mappingSize = bytes;
+    }
+    clear();
+
+    return true;
+}
+
+
+
+// save
+//
+// Write the transposition table to a binary file: a cacheFileHeader, which
+// records the Zobrist seed and the size of the table, followed by the buckets.
+bool Cache::save(const string &file, uint64_t seed)
+{
+    cacheFileHeader header;
+    ofstream out(file, ios::binary | ios::trunc);
+
+
+    if (!out.is_open())
+    {
+        cerr << "Cannot open " << file << " to save the cache!" << endl;
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CHESS0TT", sizeof(header.magic));
+    header.version    = CACHE_FILE_VERSION;
+    header.bucketSize = sizeof(ttBucket);
+    header.seed       = seed;
+    header.buckets    = buckets;
+    header.used       = used;
+
+    out.write((const char *) &header, sizeof(header));
+    out.write((const char *) table, buckets * sizeof(ttBucket));
+    out.close();
+
+    if (out.fail())
+    {
+        cerr << "Cannot write the cache to " << file << "!" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+// load
+//
+// Map a transposition table saved with save() back into memory. The file is
+// mapped privately, so pages are only read from disk when the search touches
+// them and the search never writes back to the file. The table takes the size
+// recorded in the file. Files from another version, or whose keys were made
+// with a different Zobrist seed, are rejected and the current table is kept.
+bool Cache::load(const string &file, uint64_t seed)
+{
+    int fd;
+    struct stat st;
+    void *map;
+    cacheFileHeader *header;
+
+
+    fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        cerr << "Cannot open " << file << " to load the cache!" << endl;
+        return false;
+    }
+
+    if ((fstat(fd, &st) < 0) || ((uint64_t) st.st_size < sizeof(cacheFileHeader)))
+    {
+        cerr << file << " is not a valid cache file!" << endl;
+        close(fd);
+        return false;
+    }
+
+    map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        cerr << "Cannot map " << file << " into memory!" << endl;
+        return false;
+    }
+
+
+    // check that the file is a table we can use (the number of buckets is
+    // checked against the file size before multiplying, so it cannot wrap)
+    header = (cacheFileHeader *) map;
+    if (memcmp(header->magic, "CHESS0TT", sizeof(header->magic)) ||
+        (header->version != CACHE_FILE_VERSION) ||
+        (header->bucketSize != sizeof(ttBucket)) ||
+        (header->buckets == 0) || (header->buckets & (header->buckets - 1)) ||
+        (header->buckets > ((uint64_t) st.st_size - sizeof(cacheFileHeader)) / sizeof(ttBucket)) ||
+        ((uint64_t) st.st_size != sizeof(cacheFileHeader) + header->buckets * sizeof(ttBucket)) ||
+        (header->used > header->buckets * TT_BUCKET_SIZE))
+    {
+        cerr << file << " is not a valid cache file!" << endl;
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    if (header->seed != seed)
+    {
+        cerr << file << " was saved with different hash keys!" << endl;
+        munmap(map, st.st_size);
+        return false;
+    }
+
+
+    // replace the current table with the mapped one
+    release();
+    mapping     = map;
+    mappingSize = st.st_size;
+    table       = (ttBucket *) ((char *) map + sizeof(cacheFileHeader));
+    buckets     = header->buckets;
+    mask        = buckets - 1;
+    used        = header->used;
+    backing     = CACHE_BACKING_FILE;
+
+    return true;
+}
+
+
+
 // find
 //
-// Look for a ttEntry in the cache.
-ttEntry Cache::find(uint64_t key, int depth)
+// Look for a ttEntry in the cache. If the position is not found, the returned
+// entry is empty (key = 0). It is up to the caller to decide whether the depth
+// and the bound of the entry are good enough for its purpose. An entry that is
+// found is still useful, so it takes the generation of the current search.
+ttEntry Cache::find(uint64_t key)
 {
-    ttEntry tt, ttfalse;
+    ttEntry ttfalse;
+    ttBucket *bucket = &table[key & mask];
+
+    stats.probes++;
+    for (int i = 0; i < TT_BUCKET_SIZE; i++)
+    {
+        // copy the entry first, other threads may be writing it
+        ttEntry e = bucket->entry[i];
+
+        if ((e.key ^ ttData(e)) == key)
+        {
+            e.generation = generation;
+            e.key = key ^ ttData(e);
+            bucket->entry[i] = e;
+            stats.hits++;
+
+            e.key = key;
+            return e;
+        }
+    }
+
+    // slots are filled in order, so the bucket is full if its last one is taken
+    if (bucket->entry[TT_BUCKET_SIZE - 1].key != 0)
+        stats.collisions++;
+
+    return ttfalse;
+}
 
-    auto search = cacheData.find(key);
 
-    if (search != cacheData.end())
+
+// peek
+//
+// Look for a ttEntry in the cache like find() does, but without counting the
+// probe in the statistics or refreshing the generation of the entry. This is
+// for lookups that only may use the entry, such as the positions after each
+// move in enhanced transposition cutoffs.
+ttEntry Cache::peek(uint64_t key)
+{
+    ttEntry ttfalse;
+    ttBucket *bucket = &table[key & mask];
+
+    for (int i = 0; i < TT_BUCKET_SIZE; i++)
     {
-        tt = search->second;
+        // copy the entry first, other threads may be writing it
+        ttEntry e = bucket->entry[i];
 
-        if ((tt.key == key) && (tt.depth >= depth))
-            return tt;
+        if ((e.key ^ ttData(e)) == key)
+        {
+            e.key = key;
+            return e;
+        }
     }
 
     return ttfalse;
@@ -56,10 +338,79 @@ ttEntry Cache::find(uint64_t key, int depth)
 
 // add
 //
-// Insert a new ttEntry in the cache.
+// Insert a new ttEntry in the cache. The entry replaces the one already stored
+// for the same position, unless that one is deeper, comes from the current
+// search and the new one is not exact. Otherwise it takes an empty slot in the
+// bucket or, if the bucket is full, the slot chosen by the replacement policy:
+// the lowest depth, where every search of age costs TT_AGE_WEIGHT plies, or
+// simply the slot selected by the key when always replacing.
 void Cache::add(uint64_t key, ttEntry *tt)
 {
-    cacheData[key] = *tt;
+    ttBucket *bucket = &table[key & mask];
+    ttEntry *replace = nullptr;
+    ttEntry stored = *tt;
+    int age, value, lowest = 0;
+
+
+    stored.generation = generation;
+    stored.key = key ^ ttData(stored);
+
+
+    // 1. the same position, or else the first empty slot
+    for (int i = 0; i < TT_BUCKET_SIZE; i++)
+    {
+        ttEntry *e = &bucket->entry[i];
+
+        if ((e->key ^ ttData(*e)) == key)
+        {
+            if ((policy == TT_REPLACE_DEPTH) && (e->generation == generation) &&
+                (e->depth > tt->depth) && (tt->bound != TT_BOUND_EXACT))
+            {
+                if (e->move == 0)
+                {
+                    e->move = tt->move;
+                    e->key  = key ^ ttData(*e);
+                }
+                return;
+            }
+
+            *e = stored;
+            return;
+        }
+
+        if ((e->key == 0) && (replace == nullptr))
+            replace = e;
+    }
+
+
+    // 2. the bucket is full, pick a victim
+    if (replace == nullptr)
+    {
+        if (policy == TT_REPLACE_ALWAYS)
+            replace = &bucket->entry[(key >> 32) % TT_BUCKET_SIZE];
+        else
+        {
+            for (int i = 0; i < TT_BUCKET_SIZE; i++)
+            {
+                ttEntry *e = &bucket->entry[i];
+
+                age   = (TT_GENERATIONS + generation - e->generation) % TT_GENERATIONS;
+                value = e->depth - TT_AGE_WEIGHT * age;
+                if ((replace == nullptr) || (value < lowest))
+                {
+                    replace = e;
+                    lowest  = value;
+                }
+            }
+        }
+    }
+
+    if (replace->key == 0)
+        used++;
+    else
+        stats.overwrites++;
+
+    *replace = stored;
 }
 
 
@@ -69,17 +420,73 @@ void Cache::add(uint64_t key, ttEntry *tt)
 // Remove a ttEntry from the cache.
 void Cache::remove(uint64_t key)
 {
-    cacheData.erase(key);
+    ttBucket *bucket = &table[key & mask];
+
+    for (int i = 0; i < TT_BUCKET_SIZE; i++)
+    {
+        if ((bucket->entry[i].key ^ ttData(bucket->entry[i])) == key)
+        {
+            bucket->entry[i] = ttEntry();
+            used--;
+        }
+    }
 }
 
 
 
 // clear
 //
-// Empty the entire cache structure.
+// Empty the entire cache structure. The table is split in slices cleared by
+// as many short-lived threads as will search. These are not the search
+// threads and are not pinned, but the scheduler usually spreads them over
+// the CPUs, so on multi-socket hosts the pages tend to be first touched (and
+// allocated) on several nodes instead of all on the node of a single thread.
 void Cache::clear()
 {
-    cacheData.clear();
+    vector<thread> workers;
+    uint64_t slice = buckets / threads;
+
+
+    if ((threads == 1) || (slice == 0))
+    {
+        memset((void *) table, 0, buckets * sizeof(ttBucket));
+        used = 0;
+        resetStats();
+        return;
+    }
+
+    for (int t = 0; t < threads; t++)
+    {
+        uint64_t first = t * slice;
+        uint64_t count = (t == threads - 1) ? (buckets - first) : slice;
+
+        workers.emplace_back([this, first, count]()
+        {
+            memset((void *) &table[first], 0, count * sizeof(ttBucket));
+        });
+    }
+
+    for (thread &w : workers)
+        w.join();
+
+    used = 0;
+    resetStats();
+}
+
+
+
+// backingName
+//
+// Describe the kind of memory backing the transposition table.
+const char *Cache::backingName()
+{
+    switch (backing)
+    {
+        case CACHE_BACKING_HUGETLB: return "2 MB huge pages";
+        case CACHE_BACKING_THP:     return "transparent huge pages";
+        case CACHE_BACKING_FILE:    return "mapped from file";
+        default:                    return "regular pages";
+    }
 }
 
 
@@ -89,7 +496,27 @@ void Cache::clear()
 // Return the number of entries stored in the cache.
 uint64_t Cache::positions()
 {
-    return cacheData.size();
+    return used;
+}
+
+
+
+// capacity
+//
+// Return the maximum number of entries that fit in the cache.
+uint64_t Cache::capacity()
+{
+    return buckets * TT_BUCKET_SIZE;
+}
+
+
+
+// hashfull
+//
+// Return how full the cache is, in permille, as reported to UCI interfaces.
+int Cache::hashfull()
+{
+    return (int) (used * 1000 / capacity());
 }
 
 
@@ -100,7 +527,17 @@ uint64_t Cache::positions()
 // structures.
 uint64_t Cache::size()
 {
-    return cacheData.size() * BOARD_SERIAL_SIZE;
+    return buckets * sizeof(ttBucket);
+}
+
+
+
+// sizeMB
+//
+// Return the total memory size (in MB) occupied by the cache.
+uint64_t Cache::sizeMB()
+{
+    return size() / (1024 * 1024);
 }
 
 
@@ -109,8 +546,59 @@ uint64_t Cache::size()
 // Print out the entire cache memory structure.
 void Cache::dump()
 {
-    for (auto i : cacheData)
+    for (uint64_t b = 0; b < buckets; b++)
+    {
+        for (int i = 0; i < TT_BUCKET_SIZE; i++)
+        {
+            ttEntry &tt = table[b].entry[i];
+
+            if (tt.key != 0)
+            {
+                cout << "Key = " << (tt.key ^ ttData(tt)) << " => {score = " << tt.score << "; depth = " << (int) tt.depth;
+                cout << "; bound = " << (int) tt.bound << "; generation = " << (int) tt.generation << "; move = " << tt.move << "}" << endl;
+            }
+        }
+    }
+}
+
+
+
+// EvalCache::find
+//
+// Look up the static evaluation of the position with the given hash key.
+bool EvalCache::find(uint64_t key, int &score)
+{
+    uint64_t entry = table[key & (EVAL_CACHE_SIZE - 1)];
+
+    if ((entry & ~0xFFFFULL) == (key & ~0xFFFFULL))
     {
-        cout << "Key = " << i.first << " => {score = " << (i.second).score << "; depth = " << (i.second).depth << "}" << endl;
+        score = (int16_t) (entry & 0xFFFF);
+        hits++;
+        return true;
     }
+
+    misses++;
+    return false;
+}
+
+
+
+// EvalCache::add
+//
+// Store the static evaluation of the position with the given hash key.
+void EvalCache::add(uint64_t key, int score)
+{
+    table[key & (EVAL_CACHE_SIZE - 1)] = (key & ~0xFFFFULL) | (uint16_t) score;
+}
+
+
+
+// EvalCache::clear
+//
+// Remove all the entries and reset the counters.
+void EvalCache::clear()
+{
+    memset(table, 0, sizeof(table));
+    hits   = 0;
+    misses = 0;
 }
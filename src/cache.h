@@ -22,12 +22,17 @@
 //
 // This file describes the data structures to store transposition tables (a.k.a.
 // chess board posititions cache memory).
+//
+// The transposition table is a preallocated block of memory, divided into
+// buckets of TT_BUCKET_SIZE entries each. Every bucket is exactly one cache
+// line long, and the number of buckets is always a power of two, so the bucket
+// for a given position is found by masking the low bits of its hash key.
 #ifndef _CACHE_H_
 #define _CACHE_H_
 
 
 #include <string>
-#include <unordered_map>
+#include <string.h>
 #include "move.h"
 
 
@@ -35,11 +40,115 @@ using namespace std;
 
 
 
+// Type of score stored in a ttEntry:
+//  - TT_BOUND_EXACT: the score is the exact value of the position
+//  - TT_BOUND_LOWER: the search failed high, the real score is >= score
+//  - TT_BOUND_UPPER: the search failed low, the real score is <= score
+enum ttBound
+{
+    TT_BOUND_NONE  = 0,
+    TT_BOUND_UPPER = 1,
+    TT_BOUND_LOWER = 2,
+    TT_BOUND_EXACT = 3,
+};
+
+
+
+// Replacement policies when a bucket is full:
+//  - TT_REPLACE_DEPTH: evict the entry with the lowest depth, counting every
+//                      search of age as TT_AGE_WEIGHT plies less
+//  - TT_REPLACE_ALWAYS: evict the slot selected by the key (for comparison)
+enum ttReplace
+{
+    TT_REPLACE_DEPTH  = 0,
+    TT_REPLACE_ALWAYS = 1,
+};
+
+
+
+// Each entry is 16 bytes, so that a bucket of 4 entries fits in a cache line.
+// The bound shares its byte with the generation of the search that stored or
+// last used the entry.
+//
+// The table is shared by all the search threads without locks. To detect an
+// entry torn by two threads writing it at the same time, the key is stored
+// XOR-ed with the other 8 bytes of the entry (see ttData), so a torn entry no
+// longer matches the key of any position.
 struct ttEntry
 {
     uint64_t key   =  0;
-    int      depth =  TT_EMPTY_VALUE;
-    int      score =  0;
+    int      move  =  0;                // best move found (Move::moveInt)
+    int16_t  score =  0;
+    int8_t   depth =  TT_EMPTY_VALUE;   // remaining depth of the search
+    uint8_t  bound : 2;
+    uint8_t  generation : 6;
+
+    ttEntry() : bound(TT_BOUND_NONE), generation(0) {}
+};
+
+
+
+// ttData
+//
+// Return the 8 bytes of an entry that follow the key, as one word.
+inline uint64_t ttData(const ttEntry &e)
+{
+    uint64_t data;
+
+    memcpy(&data, (const char *) &e + sizeof(e.key), sizeof(data));
+    return data;
+}
+
+
+
+struct alignas(64) ttBucket
+{
+    ttEntry entry[TT_BUCKET_SIZE];
+};
+
+
+
+// Kind of memory backing the transposition table.
+enum cacheBacking
+{
+    CACHE_BACKING_PAGES   = 0,          // regular pages
+    CACHE_BACKING_THP     = 1,          // transparent huge pages (madvise)
+    CACHE_BACKING_HUGETLB = 2,          // explicit 2 MB huge pages
+    CACHE_BACKING_FILE    = 3,          // mapped from a cache file
+};
+
+
+
+// Counters of the transposition table, kept since it was last cleared:
+//  - probes:     lookups of a position
+//  - hits:       lookups that found the position
+//  - cutoffs:    hits that the search could use to return a score right away
+//  - collisions: lookups that missed in a full bucket, i.e. other positions
+//                took the slots that the position maps to
+//  - overwrites: stores that evicted another position from a full bucket
+// The search threads update them without locks, so with several threads they
+// are approximate.
+struct cacheStats
+{
+    uint64_t probes     = 0;
+    uint64_t hits       = 0;
+    uint64_t cutoffs    = 0;
+    uint64_t collisions = 0;
+    uint64_t overwrites = 0;
+};
+
+
+
+// Header of a cache file, followed by all the buckets of the table. It is one
+// cache line long, so that the buckets stay aligned when the file is mapped.
+struct alignas(64) cacheFileHeader
+{
+    char     magic[8];                  // "CHESS0TT"
+    uint32_t version;                   // CACHE_FILE_VERSION
+    uint32_t bucketSize;                // sizeof(ttBucket)
+    uint64_t seed;                      // Zobrist seed of the keys in the table
+    uint64_t buckets;                   // number of buckets that follow
+    uint64_t used;                      // number of non-empty entries
 };
 
 
@@ -47,18 +156,94 @@ struct ttEntry
 class Cache
 {
     private:
-        std::unordered_map<uint64_t, ttEntry> cacheData;
+        ttBucket *table   = nullptr;    // preallocated, cache-line aligned buckets
+        uint64_t  buckets = 0;          // number of buckets (power of two)
+        uint64_t  mask    = 0;          // buckets - 1, to index the table by key
+        uint64_t  used    = 0;          // number of non-empty entries
+        void     *mapping = nullptr;    // mmap() region holding the table, if any
+        uint64_t  mappingSize = 0;
+        cacheBacking backing = CACHE_BACKING_PAGES;
+        int       threads = 1;          // threads that clear (first touch) the table
+        uint8_t   generation = 0;       // age of the current search
+        ttReplace policy = TT_REPLACE_DEPTH;
+        cacheStats stats;
+
+        void     release();
 
     public:
-        ttEntry  find(uint64_t, int);
+        ~Cache();
+        bool     resize(uint64_t);
+        bool     save(const string &, uint64_t);
+        bool     load(const string &, uint64_t);
+        ttEntry  find(uint64_t);
+        ttEntry  peek(uint64_t);
+        void     prefetch(uint64_t key) { __builtin_prefetch(&table[key & mask]); }
         void     add(uint64_t, ttEntry *);
         void     remove(uint64_t);
         void     clear();
+        void     setThreads(int n) { threads = (n > 0) ? n : 1; }
+        void     newSearch() { generation = (generation + 1) % TT_GENERATIONS; }
+        void     setPolicy(ttReplace p) { policy = p; }
+        ttReplace getPolicy() { return policy; }
+        void     cutoff() { stats.cutoffs++; }
+        const cacheStats &getStats() { return stats; }
+        void     resetStats() { stats = cacheStats(); }
+        int      hashfull();
+        const char *backingName();
         uint64_t size();
+        uint64_t sizeMB();
         uint64_t positions();
+        uint64_t capacity();
         void     dump();
 };
 
 
 
+// The pawn cache stores the pawn structure terms of the evaluation, which only
+// depend on where the pawns are and can be looked up by Board::pawnkey. Scores
+// are seen from White's side, for both the middlegame and the endgame. Entries
+// never go stale, since they only depend on the key; an empty entry (key 0) is
+// also the correct evaluation of a position without pawns.
+struct pawnEntry
+{
+    uint64_t key          = 0;
+    uint64_t whitePassed  = 0;          // bitboard of white passed pawns
+    uint64_t blackPassed  = 0;          // bitboard of black passed pawns
+    int      scoreMG      = 0;
+    int      scoreEG      = 0;
+};
+
+
+
+class PawnCache
+{
+    private:
+        pawnEntry table[PAWN_CACHE_SIZE];
+
+    public:
+        pawnEntry *find(uint64_t key) { return &table[key & (PAWN_CACHE_SIZE - 1)]; }
+};
+
+
+
+// The eval cache is a direct-mapped, lossy table of static evaluations. Each
+// entry packs the upper 48 bits of the hash key and the 16-bit score in a
+// single word, and a new evaluation always replaces the old one.
+class EvalCache
+{
+    private:
+        uint64_t table[EVAL_CACHE_SIZE];
+        uint64_t hits   = 0;
+        uint64_t misses = 0;
+
+    public:
+        bool     find(uint64_t, int &);
+        void     add(uint64_t, int);
+        void     clear();
+        uint64_t getHits()   { return hits; }
+        uint64_t getMisses() { return misses; }
+};
+
+
+
 #endif // _CACHE_H_
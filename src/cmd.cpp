@@ -73,6 +73,7 @@ void initListOfCommands()
     listOfCommands.push_back("exit");
     listOfCommands.push_back("fen");
     listOfCommands.push_back("flip");
+    listOfCommands.push_back("futility");
     listOfCommands.push_back("game");
     listOfCommands.push_back("go");
     listOfCommands.push_back("help");
@@ -81,6 +82,7 @@ void initListOfCommands()
     listOfCommands.push_back("load");
     listOfCommands.push_back("manual");
     listOfCommands.push_back("moves");
+    listOfCommands.push_back("mtdf");
     listOfCommands.push_back("new");
     listOfCommands.push_back("q");
     listOfCommands.push_back("quiet");
@@ -96,8 +98,10 @@ void initListOfCommands()
     listOfCommands.push_back("show");
     listOfCommands.push_back("solve");
     listOfCommands.push_back("st");
+    listOfCommands.push_back("stats");
     listOfCommands.push_back("test");
     listOfCommands.push_back("think");
+    listOfCommands.push_back("threads");
     listOfCommands.push_back("uci");
     listOfCommands.push_back("undo");
     listOfCommands.push_back("v");
@@ -189,9 +193,51 @@ void exec(string input)
         else if ((arg == "off") || (arg == "false"))
         {
             cache.clear();
+            evalCache.clear();
             useCache = false;
         }
 
+        // change the size of the cache (in MB)
+        else if (arg == "size")
+        {
+            long long mb;
+
+            if (toNumber(arg2, CACHE_MIN_SIZE, CACHE_MAX_SIZE, mb))
+                cache.resize(mb);
+            else
+            {
+                cerr << "Invalid cache size: the size must be " << CACHE_MIN_SIZE;
+                cerr << " to " << CACHE_MAX_SIZE << " MB!" << endl;
+            }
+        }
+
+        // save the cache to a file
+        else if (arg == "save")
+        {
+            if (!arg2.empty())
+                cacheFile = arg2;
+            if (cache.save(cacheFile, KEY.seed))
+                cout << "Cache saved to " << cacheFile << "." << endl;
+        }
+
+        // load the cache from a file
+        else if (arg == "load")
+        {
+            if (!arg2.empty())
+                cacheFile = arg2;
+            if (cache.load(cacheFile, KEY.seed))
+                cout << "Cache loaded from " << cacheFile << "." << endl;
+        }
+
+        // choose the replacement policy of a full bucket
+        else if (arg == "replace")
+        {
+            if (arg2 == "depth")
+                cache.setPolicy(TT_REPLACE_DEPTH);
+            else if (arg2 == "always")
+                cache.setPolicy(TT_REPLACE_ALWAYS);
+        }
+
         // show current cache status
         if (useCache)
         {
@@ -220,7 +266,32 @@ void exec(string input)
             cout << "Current cache size: " << fixed << setprecision(2);
             cout << size << " ";
             cout << measure << "bytes (";
-            cout << cache.positions() << " positions)" << endl;
+            cout << cache.positions() << " of " << cache.capacity() << " positions)" << endl;
+            cout << "Cache memory: " << cache.backingName() << endl;
+            cout << "Cache replacement: " << ((cache.getPolicy() == TT_REPLACE_ALWAYS) ? "always" : "depth") << endl;
+
+            // detailed transposition table counters
+            if (arg == "stats")
+            {
+                const cacheStats &s = cache.getStats();
+                uint64_t probes = s.probes ? s.probes : 1;
+
+                cout << "Cache fill: " << (100.0 * cache.positions() / cache.capacity()) << "% (hashfull " << cache.hashfull() << ")" << endl;
+                cout << "Cache probes: " << s.probes << endl;
+                cout << "Cache hits: " << s.hits << " (" << (100.0 * s.hits / probes) << "%)" << endl;
+                cout << "Cache cutoffs: " << s.cutoffs << " (" << (100.0 * s.cutoffs / probes) << "%)" << endl;
+                cout << "Cache collisions: " << s.collisions << " (" << (100.0 * s.collisions / probes) << "%)" << endl;
+                cout << "Cache overwrites: " << s.overwrites << endl;
+                if (arg2 == "reset")
+                    cache.resetStats();
+            }
+
+            // eval cache usage
+            uint64_t probes = evalCache.getHits() + evalCache.getMisses();
+            cout << "Eval cache: " << evalCache.getHits() << " hits, " << evalCache.getMisses() << " misses";
+            if (probes)
+                cout << " (" << (100.0 * evalCache.getHits() / probes) << "% hit rate)";
+            cout << endl;
         }
         else
         {
@@ -252,7 +323,7 @@ void exec(string input)
 
     // lmr
     //
-    // Enable/disable late-move reductions (LMR) optimization
+    // Enable/disable late-move reductions (LMR) and late move pruning
     else if (cmd == "lmr")
     {
         if ((arg == "on") || (arg == "true"))
@@ -268,6 +339,42 @@ void exec(string input)
 
 
 
+    // futility
+    //
+    // Enable/disable futility pruning, razoring and delta pruning
+    else if (cmd == "futility")
+    {
+        if ((arg == "on") || (arg == "true"))
+            FUTILITY = true;
+        else if ((arg == "off") || (arg == "false"))
+            FUTILITY = false;
+
+        if (FUTILITY)
+            cout << "Futility pruning, razoring and delta pruning are enabled." << endl;
+        else
+            cout << "Futility pruning, razoring and delta pruning are disabled." << endl;
+    }
+
+
+
+    // mtdf
+    //
+    // Search the root with MTD(f) instead of PVS
+    else if (cmd == "mtdf")
+    {
+        if ((arg == "on") || (arg == "true"))
+            MTDF = true;
+        else if ((arg == "off") || (arg == "false"))
+            MTDF = false;
+
+        if (MTDF)
+            cout << "The root is searched with MTD(f)." << endl;
+        else
+            cout << "The root is searched with PVS and aspiration windows." << endl;
+    }
+
+
+
     // load: load position from a file
     else if (cmd == "load")
     {
@@ -403,6 +510,7 @@ void exec(string input)
         dataInit();
         board.init();
         cache.clear();
+        evalCache.clear();
         learned.clear();
         ML.clear();
 
@@ -508,6 +616,34 @@ void exec(string input)
             cout << endl;
         }
 
+        // search an endgame where null move pruning must not cut the pawn
+        // race short: Rxf1 wins a knight and is preferred up to depth 13, but
+        // the search should switch to d4xc5 at depth 14. This is not a real
+        // zugzwang, just a deep line that a wrong null move fail high would
+        // hide. The search needs the cache to get that deep, so it is cleared
+        // and used for this test only.
+        else if (arg == "null")
+        {
+            static Board saved;
+            char fen[] = "5R2/1K4p1/8/2p5/1p1P4/7P/PP1k4/5n2", color[] = "w";
+            char castling[] = "-", enpassant[] = "-";
+            Move best;
+
+            cout << "Testing null move verification: " << flush;
+
+            saved = board;
+            useCache = true;
+            cache.clear();
+            setupFen(fen, color, castling, enpassant, 0, 1);
+            board.searchDepth = NULLMOVE_TEST_DEPTH;
+            board.maxTime = NODES_TEST_TIME * 1000;
+            best = board.think();
+
+            cout << moveToUCI(best) << ((moveToUCI(best) == "d4c5") ? " ok" : " FAILED (d4c5 expected)") << endl;
+            board = saved;
+            useCache = wasUsingCache;
+        }
+
         else
         {
             cout << "Testing node search speed: " << endl << endl << flush;
@@ -570,6 +706,25 @@ void exec(string input)
 
 
 
+    // threads: change the number of search threads
+    else if (cmd == "threads")
+    {
+        long long n;
+
+        if (arg != "")
+        {
+            if (toNumber(arg, 1, THREADS_MAX, n))
+            {
+                searchThreads = n;
+                cache.setThreads(n);
+            }
+        }
+
+        cout << "Search threads: " << searchThreads << endl;
+    }
+
+
+
     // recall: list all learned moves for the current position
     else if (cmd == "recall")
     {
@@ -669,6 +824,14 @@ void exec(string input)
     }
 
 
+    // stats: show the counters of the last search
+    else if (cmd == "stats")
+    {
+        board.displaySearchStats(4, 0, 0);
+    }
+
+
+
     // show | display: show current board
     else if ((cmd == "show") || (cmd == "display"))
     {
@@ -829,11 +992,11 @@ void displayHelp(string which)
     if (which == "")
     {
         cout << "List of commands: (help COMMAND to get more help)" << endl;
-        cout << "analyze  auto  book  cache  depth  eval  fen  flip" << endl;
-        cout << "game  go  help  history  lmr  load  manual  new  null" << endl;
+        cout << "analyze  auto  book  cache  depth  eval  fen  flip  futility" << endl;
+        cout << "game  go  help  history  lmr  load  manual  mtdf  new  null" << endl;
         cout << "pass  quiet  quit  recall  remove  resign  restart" << endl;
-        cout << "save  sd  set  setboard  show  silent  solve  st  test" << endl;
-        cout << "think  uci  verbose  undo  version" << endl;
+        cout << "save  sd  set  setboard  show  silent  solve  st  stats" << endl;
+        cout << "test  think  threads  uci  verbose  undo  version" << endl;
         return;
     }
 
@@ -864,12 +1027,22 @@ void displayHelp(string which)
     // help cache
     else if (which == "cache")
     {
-        cout << "cache [on | off]" << endl;
+        cout << "cache [on | off | size N | save [FILE] | load [FILE] |" << endl;
+        cout << "       replace depth | replace always | stats [reset]]" << endl;
         cout << " Let the computer use the transposition tables to find" << endl;
         cout << " previously searched positions faster. This typically" << endl;
         cout << " makes the engine more powerful in middle and end-game." << endl;
-        cout << " Please note that using transposition tables can take" << endl;
-        cout << " a few hundreds of Megabytes for a ~1h game." << endl;
+        cout << " The transposition tables use a fixed amount of memory," << endl;
+        cout << " which can be changed to N Megabytes with 'cache size N'" << endl;
+        cout << " (the size is rounded down to a power of two)." << endl;
+        cout << " 'cache save' writes the cache to FILE (default " << CACHE_FILE << ")" << endl;
+        cout << " and 'cache load' maps it back into memory." << endl;
+        cout << " When a bucket is full, 'cache replace depth' keeps the" << endl;
+        cout << " deepest and most recent entries, while 'cache replace" << endl;
+        cout << " always' overwrites whatever is there." << endl;
+        cout << " 'cache stats' shows the probes, hits, cutoffs, collisions" << endl;
+        cout << " and overwrites counted since the cache was cleared, and" << endl;
+        cout << " 'cache stats reset' starts counting again." << endl;
     }
 
 
@@ -908,6 +1081,47 @@ void displayHelp(string which)
     }
 
 
+    // help futility | lmr
+    else if ((which == "futility") || (which == "lmr"))
+    {
+        cout << "futility [on | off]" << endl;
+        cout << "lmr [on | off]" << endl;
+        cout << " Enable or disable futility pruning and razoring at the" << endl;
+        cout << " last plies of the search and delta pruning in the" << endl;
+        cout << " quiescent search, or late-move reductions (LMR)" << endl;
+        cout << " and pruning." << endl;
+        cout << " Without an argument, show whether they are enabled. Use" << endl;
+        cout << " 'stats' after a search to see how many moves and nodes" << endl;
+        cout << " were pruned." << endl;
+    }
+
+
+    // help mtdf
+    else if (which == "mtdf")
+    {
+        cout << "mtdf [on | off]" << endl;
+        cout << " Search every depth with MTD(f), a series of null-window" << endl;
+        cout << " searches that converge on the score, instead of PVS with" << endl;
+        cout << " an aspiration window. MTD(f) relies on the cache, and" << endl;
+        cout << " it is not used while the cache is off. Without an" << endl;
+        cout << " argument, show which one is in use." << endl;
+    }
+
+
+    // help stats
+    else if (which == "stats")
+    {
+        cout << "stats" << endl;
+        cout << " Display the counters of the last search, such as the" << endl;
+        cout << " number of nodes, how often an aspiration window failed" << endl;
+        cout << " and the depth had to be searched again, how often a" << endl;
+        cout << " cutoff came from the first move searched, how many" << endl;
+        cout << " moves and nodes were pruned, and the share of nodes" << endl;
+        cout << " searched by the quiescent search." << endl;
+    }
+
+
+
     // help show
     else if (which == "show")
     {
@@ -1085,7 +1299,7 @@ void displayHelp(string which)
     // help test
     else if (which == "test")
     {
-        cout << "test [moves | nodes | perft]" << endl;
+        cout << "test [moves | nodes | null | perft]" << endl;
         cout << " Test either the number of moves that can be done and undone";
         cout << endl;
         cout << " per second (without calling evaluation), the number of nodes";
@@ -1096,6 +1310,10 @@ void displayHelp(string which)
         cout << endl;
         cout << " programs to test that the move generator works correctly.";
         cout << endl;
+        cout << " 'test null' checks that null move pruning does not hide";
+        cout << endl;
+        cout << " the best move of a position at depth 14 (it clears the cache).";
+        cout << endl;
         cout << " If no argument is given, all three tests are performed.";
         cout << endl;
         cout << " Please note that the efficiency of the tests will depend";
@@ -1119,6 +1337,20 @@ void displayHelp(string which)
 
 
 
+    // help threads
+    else if (which == "threads")
+    {
+        cout << "threads [N]" << endl;
+        cout << " Search with N threads in parallel (1 to " << THREADS_MAX << ")." << endl;
+        cout << " The helper threads search the same position and share" << endl;
+        cout << " the transposition tables with the main thread, which" << endl;
+        cout << " then reaches the same depth sooner. If no number is" << endl;
+        cout << " given, then the application tells how many threads" << endl;
+        cout << " are used." << endl;
+    }
+
+
+
     // help uci
     else if (which == "uci")
     {
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <iostream>
 #include <iomanip>
 #include "definitions.h"
@@ -43,6 +44,7 @@ void dataInit()
     unsigned char CHARBITSET[8];
     int i, square, rank, file, arank, afile, state, slide, diaga1h8, diaga8h1, attackbit;
     unsigned char state6Bit, state8Bit, attack8Bit;
+    int lmrDepth, lmrMove, next;
     Move move;
 
 
@@ -825,6 +827,37 @@ void dataInit()
         }
 
 
+    // squares between two squares on the same line, and the whole line
+    for (i = 0; i < 64; i++)
+        for (square = 0; square < 64; square++)
+        {
+            BETWEEN[i][square] = 0;
+            LINE[i][square] = 0;
+            if (!HEADINGS[i][square])
+                continue;
+
+            for (next = i + HEADINGS[i][square]; next != square; next += HEADINGS[i][square])
+                BETWEEN[i][square] |= BITSET[next];
+
+            LINE[i][square] = BITSET[i];
+            for (next = 0; next < 64; next++)
+                if ((HEADINGS[i][next] == HEADINGS[i][square]) || (HEADINGS[i][next] == -HEADINGS[i][square]))
+                    LINE[i][square] |= BITSET[next];
+        }
+
+
+    // late move reductions grow with the logarithm of both the remaining
+    // depth and the number of moves searched before (see alphabetapvs)
+    for (lmrDepth = 0; lmrDepth < MAX_PLY; lmrDepth++)
+        for (lmrMove = 0; lmrMove < LMR_MAX_MOVES; lmrMove++)
+            LMR_REDUCTIONS[lmrDepth][lmrMove] = (lmrDepth && lmrMove) ?
+                (int) (LMR_BASE + log(lmrDepth) * log(lmrMove) / LMR_DIVISOR) : 0;
+
+
+    // material signature table
+    materialInit();
+
+
     // required for running test suites, to prevent 
     // writing escape characters to a file
     TO_CONSOLE = 1;
@@ -42,6 +42,7 @@
 #define MAX_CMD_BUFF     256   // Console command input buffer
 #define MAX_INPUT_SIZE   256   // Console command input buffer
 #define MAX_MOV_BUFF    4096   // Max number of moves that we can store (all plies)
+#define MAX_MOVES        256   // Max number of moves in one position
 #define MAX_PLY           64   // Max search depth
 #define MAX_GAME_LINE   1024   // Max number of moves in the (game + search) line that we can store
 
@@ -49,11 +50,31 @@
 
 // Search algorithm configuration
 #define AI_SEARCH_DEPTH           64
-#define SEARCH_WINDOW_SIZE        16
+#define SEARCH_WINDOW_SIZE        64
+#define MTDF_STEP                 16   // first step of MTD(f) away from the guess
 #define TIME_PER_MOVE              5
-#define LMR_PLY_START              3
-#define LMR_MOVE_START             3
-#define LMR_SEARCH_DEPTH           3
+#define LMR_MOVE_START             3   // moves searched at full depth
+#define LMR_SEARCH_DEPTH           3   // min. depth to reduce moves
+#define LMR_MAX_MOVES             64   // size of the LMR_REDUCTIONS table
+#define LMR_BASE                0.75
+#define LMR_DIVISOR             2.25
+#define LMP_DEPTH                  3   // max. depth to prune late moves
+#define LMP_MOVE_START             3   // ... after LMP_MOVE_START + depth^2 moves
+#define FUTILITY_DEPTH             2
+#define FUTILITY_MARGIN          150   // per ply of remaining depth
+#define RAZOR_DEPTH                2
+#define RAZOR_MARGIN             300
+#define DELTA_MARGIN             200   // qsearch delta pruning safety margin
+#define NULLMOVE_DEPTH_DIVISOR     4   // null move reduction: +1 ply every 4 plies
+#define NULLMOVE_EVAL_DIVISOR    200   // ... and +1 ply every 200 above beta
+#define NULLMOVE_EVAL_MAX          2   // ... up to 2 plies
+#define NULLMOVE_VERIFY_DEPTH     10   // min. depth to verify null move fail highs
+#define PROBCUT_DEPTH              5   // min. depth for ProbCut
+#define PROBCUT_REDUCTION          4
+#define PROBCUT_MARGIN           200   // over beta, for the reduced search
+#define ETC_DEPTH                  6   // min. depth for enhanced transposition cutoffs
+#define IID_DEPTH                  5   // min. depth for internal iterative deepening
+#define IID_REDUCTION              2
 
 
 #define SOLVE_MAX_DEPTH           64
@@ -61,14 +82,32 @@
 #define THINK_MAX_TIME        999999
 #define NODES_TEST_DEPTH          64
 #define NODES_TEST_TIME           20
+#define NULLMOVE_TEST_DEPTH       14
 #define MOVES_TEST_TIMES      250000
 #define MOVES_TEST_ITER    100000000
 #define PERFT_DEPTH_LIMIT          6
 
 
 #define TT_EMPTY_VALUE             0
+#define TT_BUCKET_SIZE             4   // entries per bucket (one cache line)
+#define TT_GENERATIONS            64   // searches told apart by the entry age
+#define TT_AGE_WEIGHT              8   // plies of depth worth one search of age
 #define CACHE_HIT_LEVEL          0.6
-#define BOARD_SERIAL_SIZE         16
+#define CACHE_DEFAULT_SIZE        16   // transposition table size in MB
+#define CACHE_MIN_SIZE             1
+#define CACHE_MAX_SIZE         65536
+#define THREADS_MAX              256   // max number of search threads
+#define HUGE_PAGE_SIZE       2097152   // 2 MB huge pages for the cache
+#define PAWN_CACHE_SIZE        32768   // pawn hash table entries (power of two)
+#define EVAL_CACHE_SIZE       131072   // eval cache entries (power of two)
+#define CACHE_FILE        "cache.tt"   // default file to save/load the cache
+#define CACHE_FILE_VERSION         2
+#define ZOBRIST_SEED 0x9E3779B97F4A7C15ULL
+#define MATERIAL_MAX_PAWNS         8   // piece counts covered by the material table
+#define MATERIAL_MAX_PIECES        2   // knights, bishops and rooks
+#define MATERIAL_MAX_QUEENS        1
+#define MATERIAL_TABLE_SIZE   236196   // (9 * 3 * 3 * 3 * 2) ^ 2 material signatures
+#define MATERIAL_OVERFLOW 0x40000000   // flag for material keys outside the table
 
 
 
@@ -77,15 +77,15 @@ void displayPV()
     int i;
     char sanMove[12];
 
-    for (i = 0; i < board.triangularLength[0]; i++) 
+    for (i = 0; i < board.ss[0].pvLength; i++) 
     {
-        toSan(board.triangularArray[0][i], sanMove);
+        toSan(board.ss[0].pv[i], sanMove);
         cout << sanMove << " ";
-        makeMove(board.triangularArray[0][i]);
+        makeMove(board.ss[0].pv[i]);
     }
-    for (i = board.triangularLength[0]-1; i >= 0; i--) 
+    for (i = board.ss[0].pvLength-1; i >= 0; i--) 
     {
-        unmakeMove(board.triangularArray[0][i]);
+        unmakeMove(board.ss[0].pv[i]);
     }
 
     // make sure to overwrite any remaining output of mode 3
@@ -105,14 +105,14 @@ void displayUCIPV()
 {
     int i;
 
-    for (i = 0; i < board.triangularLength[0]; i++) 
+    for (i = 0; i < board.ss[0].pvLength; i++) 
     {
-        cout << moveToUCI(board.triangularArray[0][i]) << " ";
-        makeMove(board.triangularArray[0][i]);
+        cout << moveToUCI(board.ss[0].pv[i]) << " ";
+        makeMove(board.ss[0].pv[i]);
     }
-    for (i = board.triangularLength[0]-1; i >= 0; i--) 
+    for (i = board.ss[0].pvLength-1; i >= 0; i--) 
     {
-        unmakeMove(board.triangularArray[0][i]);
+        unmakeMove(board.ss[0].pv[i]);
     }
 
     // make sure to overwrite any remaining output of mode 3
@@ -139,7 +139,7 @@ void displayUCIPV()
 //  '+'is added for check, '#' is added for mate.
 bool toSan(Move &move, char *sanMove)
 {
-    unsigned int i, j, k, ibuf, from, to, piece, capt, prom, ambigfile, ambigrank;
+    unsigned int i, ibuf, iend, from, to, piece, capt, prom, ambigfile, ambigrank;
     int asciiShift;
     bool legal, check, mate, ambig;
 
@@ -159,54 +159,41 @@ bool toSan(Move &move, char *sanMove)
     sprintf(sanMove, "");
 
 
-    //  Generate all pseudo-legal moves to be able to remove any ambiguities 
-    //  and check legality. Take the next free location in moveBufLen:
-    while (board.moveBufLen[ibuf+1]) ibuf++;
-    board.moveBufLen[ibuf+1] = movegen(board.moveBufLen[ibuf]);
+    //  Generate all legal moves to be able to remove any ambiguities 
+    //  and check legality. Take the buffer past the moves of every ply, since
+    //  this may be called in the middle of a search:
+    for (i = 0; i < MAX_PLY + 2; i++)
+        ibuf = max(ibuf, board.moveBufLen[i]);
+    iend = legalgen(ibuf);
 
 
     //  Loop over the moves to see what kind(s) of ambiguities exist, if any:
-    for (i = board.moveBufLen[ibuf]; i < board.moveBufLen[ibuf+1]; i++)
+    for (i = ibuf; i < iend; i++)
     {
-        makeMove(board.moveBuffer[i]);
-        if (!isOtherKingAttacked())
+        if (board.moveBuffer[i].moveInt == move.moveInt) 
         {
-            if (board.moveBuffer[i].moveInt == move.moveInt) 
+            legal = true;
+            makeMove(board.moveBuffer[i]);
+            // it is check:
+            if (isOwnKingAttacked()) 
             {
-                legal = true;
-                // it is check:
-                if (isOwnKingAttacked()) 
-                {
-                    check = true;
-                    // is it checkmate?
-                    k = 0;
-                    board.moveBufLen[ibuf+2] = movegen(board.moveBufLen[ibuf+1]);
-                    for (j = board.moveBufLen[ibuf+1]; j < board.moveBufLen[ibuf+2]; j++)
-                    {
-                        makeMove(board.moveBuffer[j]);
-                        if (!isOtherKingAttacked()) k++;
-                        unmakeMove(board.moveBuffer[j]);
-                    }
-                    if (!k) mate = true;
-                }
-            }
-            // two same pieces can move to the same square:
-            if ((board.moveBuffer[i].moveInt != move.moveInt) && (board.moveBuffer[i].getPiece() == piece) && (board.moveBuffer[i].getTosq() == to)) 
-            {
-                ambig = true;
-                if (FILES[from] == FILES[board.moveBuffer[i].getFrom()]) ambigfile++; 
-                if (RANKS[from] == RANKS[board.moveBuffer[i].getFrom()]) ambigrank++; 
+                check = true;
+                // is it checkmate?
+                if (!legalMoveCount(iend))
+                    mate = true;
             }
+            unmakeMove(board.moveBuffer[i]);
+        }
+        // two same pieces can move to the same square:
+        if ((board.moveBuffer[i].moveInt != move.moveInt) && (board.moveBuffer[i].getPiece() == piece) && (board.moveBuffer[i].getTosq() == to)) 
+        {
+            ambig = true;
+            if (FILES[from] == FILES[board.moveBuffer[i].getFrom()]) ambigfile++; 
+            if (RANKS[from] == RANKS[board.moveBuffer[i].getFrom()]) ambigrank++; 
         }
-        unmakeMove(board.moveBuffer[i]);
     }
 
 
-    //  cleanup:
-    board.moveBufLen[ibuf+1] = 0;
-    board.moveBufLen[ibuf+2] = 0;
-
-
     //  construct the SAN string:
     if (!legal) 
     {
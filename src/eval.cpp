@@ -39,154 +39,175 @@
 
 
 
-// Board::eval
+// evalPawnStructure
 //
-// This is Chess0's evaluation function, including both material and positional
-// evaluation.
-int Board::eval()
+// Evaluate the pawn structure terms that only depend on the placement of the
+// pawns (position, passed, doubled, isolated and backward pawns), for both the
+// middlegame and the endgame, and store them in the given pawn cache entry.
+static void evalPawnStructure(pawnEntry *pawns)
 {
-
-    int score, square;
-    int whitepawns, whiteknights, whitebishops, whiterooks, whitequeens;
-    int blackpawns, blackknights, blackbishops, blackrooks, blackqueens;
-    int whitekingsquare, blackkingsquare;
-    int whitetotalmat, blacktotalmat;
-    int whitetotal, blacktotal;
-    bool endgame;
-    Bitboard temp, whitepassedpawns, blackpassedpawns, allpieces;
+    int square;
+    int mg = 0, eg = 0;
+    Bitboard temp, whitepassedpawns = 0, blackpassedpawns = 0;
 
 
-    // 1. count material
-    score = board.Material;
+    // 1. white pawns
+    temp = board.whitePawns;
+    while (temp)
+    {
+        square = firstOne(temp);
 
+        mg += PAWNPOS_W_MG[square];
+        eg += PAWNPOS_W_EG[square];
 
-    // 2. check where kings and pieces are
-    // 2.1 Kings
-    whitekingsquare = firstOne(board.whiteKing);
-    blackkingsquare = firstOne(board.blackKing);
+        if (!(PASSED_WHITE[square] & board.blackPawns))
+        {
+            mg += BONUS_PASSED_PAWN;
+            eg += BONUS_PASSED_PAWN;
 
+            // remember its location, we need it later when evaluating the white rooks
+            whitepassedpawns ^= BITSET[square];
+        }
 
-    // 2.2 Pieces
-    whitepawns = bitCnt(board.whitePawns);
-    whiteknights = bitCnt(board.whiteKnights);
-    whitebishops = bitCnt(board.whiteBishops);
-    whiterooks = bitCnt(board.whiteRooks);
-    whitequeens = bitCnt(board.whiteQueens);
-    whitetotalmat = 3 * whiteknights + 3 * whitebishops + 5 * whiterooks + 10 * whitequeens;
-    whitetotal = whitepawns + whiteknights + whitebishops + whiterooks + whitequeens;
-    blackpawns = bitCnt(board.blackPawns);
-    blackknights = bitCnt(board.blackKnights);
-    blackbishops = bitCnt(board.blackBishops);
-    blackrooks = bitCnt(board.blackRooks);
-    blackqueens = bitCnt(board.blackQueens);
-    blacktotalmat = 3 * blackknights + 3 * blackbishops + 5 * blackrooks + 10 * blackqueens;
-    blacktotal = blackpawns + blackknights + blackbishops + blackrooks + blackqueens;
-    allpieces = board.whitePawns | board.whiteKnights | board.whiteBishops |
-                board.whiteRooks | board.whiteQueens | board.whiteKing |
-                board.blackPawns | board.blackKnights | board.blackBishops |
-                board.blackRooks | board.blackQueens | board.blackKing;
+        if ((board.whitePawns ^ BITSET[square]) & FILEMASK[square])
+        {
+            mg -= PENALTY_DOUBLED_PAWN_MG;
+            eg -= PENALTY_DOUBLED_PAWN_EG;
+        }
 
+        if (!(ISOLATED_WHITE[square] & board.whitePawns))
+        {
+            mg -= PENALTY_ISOLATED_PAWN_MG;
+            eg -= PENALTY_ISOLATED_PAWN_EG;
+        }
 
-    // 3. check if we are at the endgame: anything less than a
-    //                                    queen + rook (=15), excluding pawns,
-    //                                    is considered endgame
-    endgame = (whitetotalmat < 15 || blacktotalmat < 15);
-   
 
-    // 4. draw evaluation due to insufficient material
-    if (!whitepawns && !blackpawns)
-    {
-        // 4.1 K-K
-        if ((whitetotalmat == 0) && (blacktotalmat == 0)) 
+        // if not isolated, then it might be backward. Two conditions must be true:
+        //  1) if the next square is controlled by an enemy pawn - we use the PAWN_ATTACKS Bitboards to check this
+        //  2) if there are no pawns left that could defend this pawn
+        else
         {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
+            if ((WHITE_PAWN_ATTACKS[square + 8] & board.blackPawns))
+                if (!(BACKWARD_WHITE[square] & board.whitePawns))
+                {
+                    mg -= PENALTY_BACKWARD_PAWN_MG;
+                    eg -= PENALTY_BACKWARD_PAWN_EG;
+                }
         }
 
+        temp ^= BITSET[square];
+    }
+
 
-        // 4.2 KN-K
-        if (((whitetotalmat == 3) && (whiteknights == 1) && (blacktotalmat == 0)) ||
-                ((blacktotalmat == 3) && (blackknights == 1) && (whitetotalmat == 0))) 
+    // 2. black pawns
+    temp = board.blackPawns;
+    while (temp)
+    {
+        square = firstOne(temp);
+
+        mg -= PAWNPOS_B_MG[square];
+        eg -= PAWNPOS_B_EG[square];
+
+        if (!(PASSED_BLACK[square] & board.whitePawns))
         {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
+            mg -= BONUS_PASSED_PAWN;
+            eg -= BONUS_PASSED_PAWN;
+
+            // remember its location, we need it later when evaluating the black rooks
+            blackpassedpawns ^= BITSET[square];
         }
 
+        if ((board.blackPawns ^ BITSET[square]) & FILEMASK[square])
+        {
+            mg += PENALTY_DOUBLED_PAWN_MG;
+            eg += PENALTY_DOUBLED_PAWN_EG;
+        }
 
-        // 4.3 KNN-K (not forced mate)
-        if (((whitetotalmat == 6) && (whiteknights == 2) && (blacktotalmat == 0)) ||
-                ((blacktotalmat == 6) && (blackknights == 2) && (whitetotalmat == 0))) 
+        if (!(ISOLATED_BLACK[square] & board.blackPawns))
         {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
+            mg += PENALTY_ISOLATED_PAWN_MG;
+            eg += PENALTY_ISOLATED_PAWN_EG;
         }
 
 
-        // 4.4 KB-KB (all bishops on the same color squares)
-        if ((whitebishops + blackbishops) > 0)
+        // if not isolated, then it might be backward (see white pawns above)
+        else
         {
-            if ((whiteknights == 0) && (whiterooks == 0) && (whitequeens == 0) &&
-                (blackknights == 0) && (blackrooks == 0) && (blackqueens == 0))
-            {
-                if (!((board.whiteBishops | board.blackBishops) & WHITE_SQUARES) ||
-                        !((board.whiteBishops | board.blackBishops) & BLACK_SQUARES))
+            if ((BLACK_PAWN_ATTACKS[square - 8] & board.whitePawns))
+                if (!(BACKWARD_BLACK[square] & board.blackPawns))
                 {
-                    if (board.nextMove)
-                        return -DRAWSCORE;
-                    else
-                        return DRAWSCORE;
+                    mg += PENALTY_BACKWARD_PAWN_MG;
+                    eg += PENALTY_BACKWARD_PAWN_EG;
                 }
-            }
         }
 
+        temp ^= BITSET[square];
+    }
 
-        // 4.5 Kminor-Kminor
-        if ((whitetotalmat == 3) && (blacktotalmat == 3))
-        {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
-        }
 
+    // 3. store the result
+    pawns->key         = board.pawnkey;
+    pawns->whitePassed = whitepassedpawns;
+    pawns->blackPassed = blackpassedpawns;
+    pawns->scoreMG     = mg;
+    pawns->scoreEG     = eg;
+}
 
-        // 4.6 KNN-Kminor
-        if (((whitetotalmat == 6) && (whiteknights == 2) && (blacktotalmat == 3)) ||
-            ((blacktotalmat == 6) && (blackknights == 2) && (whitetotalmat == 3)))
-        {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
-        }
 
 
-        // 4.7 KBB-KB
-        if (((whitetotalmat == 6) && (whitebishops == 2) && (blacktotalmat == 3)) ||
-            ((blacktotalmat == 6) && (blackbishops == 2) && (whitetotalmat == 3)))
-        {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
-        }
+// Board::eval
+//
+// This is Chess0's evaluation function, including both material and positional
+// evaluation.
+int Board::eval()
+{
 
+    int score, square;
+    int whitekingsquare, blackkingsquare;
+    bool endgame;
+    Bitboard temp, whitepassedpawns, blackpassedpawns, allpieces;
+    pawnEntry *pawns;
+    const materialEntry *mat;
+    materialEntry scratch;
 
-        // 4.8 KBN-Kminor
-        if (((whitetotalmat == 6) && (whitebishops == 1) && (blacktotalmat == 3)) ||
-            ((blacktotalmat == 6) && (blackbishops == 1) && (whitetotalmat == 3)))
-        {
-            if (board.nextMove)
-                return -DRAWSCORE;
-            else
-                return DRAWSCORE;
-        }
+
+    // 1. count material
+    score = board.Material;
+
+
+    // 2. check where kings and pieces are
+    // 2.1 Kings
+    whitekingsquare = firstOne(board.whiteKing);
+    blackkingsquare = firstOne(board.blackKing);
+
+
+    // 2.2 Pieces: counts, endgame flag, draws and imbalance come from the
+    //     material signature table
+    mat = probeMaterial(scratch);
+    allpieces = board.whitePawns | board.whiteKnights | board.whiteBishops |
+                board.whiteRooks | board.whiteQueens | board.whiteKing |
+                board.blackPawns | board.blackKnights | board.blackBishops |
+                board.blackRooks | board.blackQueens | board.blackKing;
+
+
+    // 3. check if we are at the endgame: anything less than a
+    //                                    queen + rook (=15), excluding pawns,
+    //                                    is considered endgame
+    endgame = mat->endgame;
+
+
+    // 4. draw evaluation due to insufficient material (K-K, KN-K, KNN-K,
+    //    KB-KB with all bishops on the same color, Kminor-Kminor, KNN-Kminor,
+    //    KBB-KB and KBN-Kminor)
+    if ((mat->evalDraw == MATERIAL_DRAW) ||
+        ((mat->evalDraw == MATERIAL_BISHOP_DRAW) &&
+         (!((board.whiteBishops | board.blackBishops) & WHITE_SQUARES) ||
+          !((board.whiteBishops | board.blackBishops) & BLACK_SQUARES))))
+    {
+        if (board.nextMove)
+            return -DRAWSCORE;
+        else
+            return DRAWSCORE;
     }
 
 
@@ -194,94 +215,35 @@ int Board::eval()
 
     // 5.1 the winning side prefers to exchange pieces
     // (every exchange with unequal material adds 8 centipawns to the score)
-    if (whitetotalmat + whitepawns > blacktotalmat + blackpawns)
-        score +=  45 + 3 * whitetotal - 8 * blacktotal;
-    else if (whitetotalmat + whitepawns < blacktotalmat + blackpawns)
-        score += -45 - 3 * blacktotal + 8 * whitetotal;
+    score += mat->imbalance;
 
 
     // 5.2 evaluate White pieces
 
     // 5.2.1 white pawns, including:
-    //       - position on the board
+    //       - passed, doubled, isolated or backward pawns (from the pawn cache)
     //       - distance from opponent king
     //       - distance from own king
-    //       - passed, doubled, isolated or backward pawns
-    whitepassedpawns = 0;
+    pawns = pawnCache.find(board.pawnkey);
+    if (pawns->key != board.pawnkey)
+        evalPawnStructure(pawns);
+
+    score += endgame ? pawns->scoreEG : pawns->scoreMG;
+    whitepassedpawns = pawns->whitePassed;
+    blackpassedpawns = pawns->blackPassed;
+
     temp = board.whitePawns;
     while (temp)
     {
         square = firstOne(temp);
 
-        if (endgame)
-        {
-            score += PAWNPOS_W_EG[square];
-        }
-        else
-        {
-            score += PAWNPOS_W_MG[square];
-        }
-
         score += PAWN_OPPONENT_DISTANCE[DISTANCE[square][blackkingsquare]];
 
-
         if (endgame)
         {
             score += PAWN_OWN_DISTANCE[DISTANCE[square][whitekingsquare]];
         }
 
-        if (!(PASSED_WHITE[square] & board.blackPawns))
-        {
-            score += BONUS_PASSED_PAWN;
-
-            // remember its location, we need it later when evaluating the white rooks
-            whitepassedpawns ^= BITSET[square];
-        }
-
-        if ((board.whitePawns ^ BITSET[square]) & FILEMASK[square])
-        {
-            if (endgame)
-            {
-                score -= PENALTY_DOUBLED_PAWN_EG;
-            }
-            else
-            {
-                score -= PENALTY_DOUBLED_PAWN_MG;
-            }
-        }
-
-        if (!(ISOLATED_WHITE[square] & board.whitePawns))
-        {
-            if (endgame)
-            {
-                score -= PENALTY_ISOLATED_PAWN_EG;
-            }
-            else
-            {
-                score -= PENALTY_ISOLATED_PAWN_MG;
-            }
-        }
-
-
-        // if inot isolated, then it might be backward. Two conditions must be true:
-        //  1) if the next square is controlled by an enemy pawn - we use the PAWN_ATTACKS Bitboards to check this
-        //  2) if there are no pawns left that could defend this pawn
-        else
-        {
-            if ((WHITE_PAWN_ATTACKS[square + 8] & board.blackPawns))
-                if (!(BACKWARD_WHITE[square] & board.whitePawns))
-                {
-                    if (endgame)
-                    {
-                        score -= PENALTY_BACKWARD_PAWN_EG;
-                    }
-                    else
-                    {
-                        score -= PENALTY_BACKWARD_PAWN_MG;
-                    }
-                }
-        }
-
         temp ^= BITSET[square];
     }
 
@@ -474,26 +436,14 @@ int Board::eval()
 
     // 5.3 evaluate black pieces
 
-    // 5.3.1 black pawns
-    //       - position on the board
+    // 5.3.1 black pawns (the pawn structure was already evaluated in 5.2.1)
     //       - distance from opponent king
     //       - distance from own king
-    //       - passed, doubled, isolated or backward pawns
-    blackpassedpawns = 0;
     temp = board.blackPawns;
     while (temp)
     {
         square = firstOne(temp);
 
-        if (endgame)
-        {
-            score -= PAWNPOS_B_EG[square];
-        }
-        else
-        {
-            score -= PAWNPOS_B_MG[square];
-        }
-
         score -= PAWN_OPPONENT_DISTANCE[DISTANCE[square][whitekingsquare]];
 
         if (endgame)
@@ -501,58 +451,6 @@ int Board::eval()
             score -= PAWN_OWN_DISTANCE[DISTANCE[square][blackkingsquare]];
         }
 
-        if (!(PASSED_BLACK[square] & board.whitePawns))
-        {
-            score -= BONUS_PASSED_PAWN;
-
-            // remember its location, we need it later when evaluating the black rooks:
-            blackpassedpawns ^= BITSET[square];
-        }
-
-        if ((board.blackPawns ^ BITSET[square]) & FILEMASK[square])
-        {
-            if (endgame)
-            {
-                score += PENALTY_DOUBLED_PAWN_EG;
-            }
-            else
-            {
-                score += PENALTY_DOUBLED_PAWN_MG;
-            }
-        }
-
-        if (!(ISOLATED_BLACK[square] & board.blackPawns))
-        {
-            if (endgame)
-            {
-                score += PENALTY_ISOLATED_PAWN_EG;
-            }
-            else
-            {
-                score += PENALTY_ISOLATED_PAWN_MG;
-            }
-        }
-
-
-        // if not isolated, then it might be backward. Two conditions must be true:
-        //  1) if the next square is controlled by an enemy pawn - we use the PAWN_ATTACKS Bitboards to check this
-        //  2) if there are no pawns left that could defend this pawn
-        else
-        {
-            if ((BLACK_PAWN_ATTACKS[square - 8] & board.whitePawns))
-                if (!(BACKWARD_BLACK[square] & board.blackPawns))
-                {
-                    if (endgame)
-                    {
-                        score += PENALTY_BACKWARD_PAWN_EG;
-                    }
-                    else
-                    {
-                        score += PENALTY_BACKWARD_PAWN_MG;
-                    }
-                }
-        }
-
         temp ^= BITSET[square];
     }
 
@@ -27,12 +27,15 @@
 #define _EXTGLOBALS_H_
 
 #include <iostream>
+#include <atomic>
 #include <vector>
 #include <unordered_map>
 #include <vector>
 #include "definitions.h"
 #include "board.h"
 #include "hash.h"
+#include "cache.h"
+#include "material.h"
 
 using namespace std;
 
@@ -43,7 +46,8 @@ extern char PATHNAME[];
 extern char CMD_BUFF[];
 extern int CMD_BUFF_COUNT;
 
-extern Board board;
+extern thread_local Board board;
+extern thread_local PawnCache pawnCache;
 extern vector<tuple<string, string, float>> ML;
 extern vector<tuple<string, string, float>> learned;
 
@@ -99,9 +103,13 @@ extern const int ROOK_VALUE;
 extern const int QUEEN_VALUE;
 extern const int KING_VALUE;
 extern int PIECEVALUES[];
+extern int MATERIAL_WEIGHT[];
+extern materialEntry MATERIAL[];
 
 extern int MS1BTABLE[];
 
+extern int LMR_REDUCTIONS[MAX_PLY][LMR_MAX_MOVES];
+
 extern Bitboard WHITE_PAWN_ATTACKS[];
 extern Bitboard WHITE_PAWN_MOVES[];
 extern Bitboard WHITE_PAWN_DOUBLE_MOVES[];
@@ -259,6 +267,8 @@ extern Bitboard RAY_SE[];
 extern Bitboard RAY_S[];
 extern Bitboard RAY_SW[];
 extern int HEADINGS[64][64];
+extern Bitboard BETWEEN[64][64];
+extern Bitboard LINE[64][64];
 
 extern int NULLMOVE_REDUCTION;
 extern int NULLMOVE_LIMIT;
@@ -272,11 +282,17 @@ extern float winingDelta;
 extern string STARTPOS;
 
 extern bool LMR;
+extern bool FUTILITY;
+extern bool MTDF;
 
 extern bool beQuiet;
 
 extern bool UCI;
 
+extern int searchThreads;
+extern atomic<bool> stopHelpers;
+extern atomic<uint64_t> helperNodes;
+
 
 
 // UCI time controls
@@ -30,6 +30,7 @@
 #include <iostream>
 #include "board.h"
 #include "move.h"
+#include "material.h"
 
 
 
@@ -38,32 +39,44 @@ using namespace std;
 
 
 unsigned int    bitCnt(Bitboard);
-int             captgen(int);
+int             captgen(int, int);
 void            dataInit();
 void            displayBitboard(Bitboard);
 void            displayMove(Move &);
 void            displayPV();
 void            displayUCIPV();
 void            commands();
+int             evasiongen(int, LegalMasks &);
 unsigned int    firstOne(Bitboard);
 bool            isAttacked(Bitboard &, const unsigned char &);
 bool            isOtherKingAttacked();
 bool            isOwnKingAttacked();
+bool            isLegal(Move &, LegalMasks &);
+bool            isPseudoLegal(Move &);
+uint64_t        keyAfterMove(Move &);
 unsigned int    lastOne(Bitboard);
+int             legalgen(int);
+int             legalMoveCount(int);
 void            makeBlackPromotion(unsigned int, unsigned int &);
 void            makeCapture(unsigned int &, unsigned int &);
 void            makeMove(Move &);
+void            makeNullMove();
 void            makeWhitePromotion(unsigned int, unsigned int &);
+unsigned int    materialKey();
+void            materialInit();
 int             movegen(int);
 void            mstostring(uint64_t dt, char *);
 uint64_t        perft(int, int);
+const materialEntry *probeMaterial(materialEntry &);
 bool            readFen(char *);
+void            setLegalMasks(LegalMasks &);
 void            setupFen(char *, char *, char *, char *, int , int );
 void            test(char *);
 bool            toSan(Move &, char *);
 void            unmakeBlackPromotion(unsigned int, unsigned int &);
 void            unmakeCapture(unsigned int &, unsigned int &);
 void            unmakeMove(Move &);
+void            unmakeNullMove();
 void            unmakeWhitePromotion(unsigned int, unsigned int &);
 string          getInput();
 void            terminateApp();
@@ -73,6 +86,7 @@ string          getMLreply();
 bool            sortByScore(const tuple<string, string, float>&, const tuple<string, string, float>&);
 void            resetTimeControl();
 string          moveToUCI(Move);
+bool            toNumber(string, long long, long long, long long &);
 
 
 // isPiece()
@@ -39,6 +39,8 @@ struct GameLineRecord
     int epSquare;                  // En-passant target square after double pawn move
     int fiftyMove;                 // Moves since the last pawn move or capture
     uint64_t key;                  // hash key of the position
+    uint64_t pawnKey;              // hash key of the pawn structure
+    unsigned int materialKey;      // material signature of the position
 };
 
 
@@ -33,6 +33,8 @@
 #include "definitions.h"
 #include "board.h"
 #include "hash.h"
+#include "cache.h"
+#include "material.h"
 
 
 
@@ -43,7 +45,9 @@ int  CMD_BUFF_COUNT = 0;
 
 
 
-Board board;
+// every search thread works on its own board and pawn cache
+thread_local Board board;
+thread_local PawnCache pawnCache;
 vector<tuple<string, string, float>> ML;
 vector<tuple<string, string, float>> learned;
 
@@ -152,10 +156,19 @@ extern const int KING_VALUE     = 9999;
 int PIECEVALUES[16];
 
 
+// material signature table, indexed by Board::materialkey
+int MATERIAL_WEIGHT[16];
+materialEntry MATERIAL[MATERIAL_TABLE_SIZE];
+
+
 // used in Eugene Nalimov's bitScanReverse
 int MS1BTABLE[256];
 
 
+// late move reductions, indexed by remaining depth and move number
+int LMR_REDUCTIONS[MAX_PLY][LMR_MAX_MOVES];
+
+
 // Attack tables:
 Bitboard WHITE_PAWN_ATTACKS[64];
 Bitboard WHITE_PAWN_MOVES[64];
@@ -569,6 +582,12 @@ Bitboard RAY_SW[64];
 int HEADINGS[64][64];
 
 
+// used by the legal move generator, for squares on the same rank, file or
+// diagonal: squares strictly between them, and the whole line through them
+Bitboard BETWEEN[64][64];           // 32KB
+Bitboard LINE[64][64];              // 32KB
+
+
 // Nullmove parameters:
 int NULLMOVE_REDUCTION = 4;  // equivalent to R=3
 
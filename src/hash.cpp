@@ -32,14 +32,15 @@
 
 // HashKeys::init()
 //
-// Initialize all random 64-bit numbers.
-void HashKeys::init()
+// Initialize all random 64-bit numbers. The keys are generated from a fixed
+// seed, so that hash keys are the same across runs and a transposition table
+// saved to disk is still valid when it is loaded again.
+void HashKeys::init(uint64_t s)
 {
     int i,j;
-    time_t now;
 
-    // use current time (in seconds) as random seed:
-    srand((unsigned int)time(&now));
+    seed = s;
+    state = s;
 
     for (i = 0; i < 64; i++)
     {
@@ -59,8 +60,11 @@ void HashKeys::init()
 
 // HashKeys::rand64()
 //
-// Generate random Zobrist key
+// Generate random Zobrist key (xorshift64* generator).
 uint64_t HashKeys::rand64()
 {
-    return rand()^((uint64_t)rand()<<15)^((uint64_t)rand()<<30)^((uint64_t)rand()<<45)^((uint64_t)rand()<<60);
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
 }
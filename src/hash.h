@@ -42,8 +42,10 @@ struct HashKeys
     uint64_t wq;            // white queen-side castling right
     uint64_t bk;            // black king-side castling right
     uint64_t bq;            // black queen-side castling right
+    uint64_t seed;          // seed used to generate all the keys above
+    uint64_t state;         // state of the random number generator
 
-    void init();       // initialize the random data
+    void init(uint64_t = ZOBRIST_SEED); // initialize the random data
     uint64_t rand64();      // 64-bit random number generator
 };
 
@@ -101,6 +101,13 @@ void Board::readClockAndInput()
     // reset countdown
     countdown = UPDATEINTERVAL;
 
+    // helper threads only stop when the main thread is done
+    if (threadId)
+    {
+        timedout = stopHelpers;
+        return;
+    }
+
     if (((timer.getms() - msStart) > maxTime) || _kbhit())
     {
         timedout = true;
@@ -37,6 +37,7 @@
 #include <string>
 #include <cstring>
 #include <cctype>
+#include <cerrno>
 
 #include "app.h"
 #include "board.h"
@@ -131,17 +132,35 @@ string userMove = "";
 // up the search algorithm on positions that have previously appeared.
 //
 // cache is an object that holds all transposition tables and manages their
-// storage, access and all the information related.
+// storage, access and all the information related. Its memory is allocated
+// once at startup (CACHE_DEFAULT_SIZE MB), and can be resized with the command
+// 'cache size N' or with the UCI option 'Hash'.
 //
-// Note: due to being very unstable at this point, Cache is disabled by default.
-bool useCache = false;
+// evalCache keeps the static evaluation of recently evaluated positions, so
+// that quiescence search does not evaluate the same position again. Like the
+// pawn cache, every search thread has its own (the counters shown by 'cache'
+// are the ones of the main thread).
+//
+// cacheFile is the file where the cache is saved with 'cache save' (or the UCI
+// option 'SaveHash') and loaded from with 'cache load' (or 'LoadHash').
+bool useCache = true;
 Cache cache;
+thread_local EvalCache evalCache;
+string cacheFile = CACHE_FILE;
 
 
 // LMR
 bool LMR = true;
 
 
+// FUTILITY enables futility pruning and razoring at frontier nodes
+bool FUTILITY = true;
+
+
+// MTDF searches the root with MTD(f) instead of PVS with aspiration windows
+bool MTDF = false;
+
+
 // beQuiet tells whether the engine should show its analysis or not,
 // while thinking.
 bool beQuiet = false;
@@ -162,6 +181,12 @@ unsigned int MLhit = 0;
 bool UCI = false;
 
 
+// searchThreads is the number of threads searching in parallel (Lazy SMP): the
+// main thread and searchThreads - 1 helpers. It is set with 'threads N' or the
+// UCI option 'Threads'.
+int searchThreads = 1;
+
+
 
 
 // main
@@ -188,6 +213,8 @@ int main(void)
     // Initialize the board, the list of commands and the openings book
     dataInit();
     board.init();
+    cache.resize(CACHE_DEFAULT_SIZE);
+    cout << "Cache: " << cache.sizeMB() << " MB in " << cache.backingName() << "." << endl;
     initListOfCommands();
     initBook();
     learned.clear();
@@ -504,6 +531,34 @@ string getInput()
 
 
 
+// toNumber
+//
+// Read a whole number within [min, max] from a string, ignoring the spaces
+// around it. Returns false, leaving value untouched, if the string holds
+// anything else or the number is out of range.
+bool toNumber(string s, long long min, long long max, long long &value)
+{
+    const char *start = s.c_str();
+    char *end;
+    long long n;
+
+
+    errno = 0;
+    n = strtoll(start, &end, 10);
+    if ((end == start) || errno)
+        return false;
+
+    while (isspace((unsigned char) *end))
+        end++;
+    if (*end || (n < min) || (n > max))
+        return false;
+
+    value = n;
+    return true;
+}
+
+
+
 // terminateApp
 //
 // Terminate the app in a safe way.
@@ -944,37 +999,28 @@ map<string, string> getValidMoves(void)
     string tmpStr = "";
     string s1 = "", s2 = "";
     board.moveBufLen[0] = 0;
-    board.moveBufLen[1] = movegen(board.moveBufLen[0]);
+    board.moveBufLen[1] = legalgen(board.moveBufLen[0]);
 
     for (auto i = board.moveBufLen[0]; i < board.moveBufLen[1]; i++)
     {
-        makeMove(board.moveBuffer[i]);
-        if (isOtherKingAttacked())
+        toSan(board.moveBuffer[i], sanMove);
+
+        string moveStr(sanMove);
+        s1 = SQUARENAME[(board.moveBuffer[i]).getFrom()];
+        s2 = SQUARENAME[(board.moveBuffer[i]).getTosq()];
+        tmpStr = s1 + s2;
+        moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '+'), moveStr.end());
+        moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '#'), moveStr.end());
+
+        // if promo, append promo piece
+        if ((board.moveBuffer[i]).isPromo())
         {
-            unmakeMove(board.moveBuffer[i]);
+            string tc(PIECECHARS[(board.moveBuffer[i]).getPromo()]);
+            tmpStr += tc;
+            transform(tmpStr.begin(), tmpStr.end(), tmpStr.begin(), ::tolower);
         }
-        else
-        {
-            unmakeMove(board.moveBuffer[i]);
-            toSan(board.moveBuffer[i], sanMove);
-
-            string moveStr(sanMove);
-            s1 = SQUARENAME[(board.moveBuffer[i]).getFrom()];
-            s2 = SQUARENAME[(board.moveBuffer[i]).getTosq()];
-            tmpStr = s1 + s2;
-            moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '+'), moveStr.end());
-            moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '#'), moveStr.end());
-
-            // if promo, append promo piece
-            if ((board.moveBuffer[i]).isPromo())
-            {
-                string tc(PIECECHARS[(board.moveBuffer[i]).getPromo()]);
-                tmpStr += tc;
-                transform(tmpStr.begin(), tmpStr.end(), tmpStr.begin(), ::tolower);
-            }
 
-            listOfValidMoves[moveStr] = tmpStr;
-        }
+        listOfValidMoves[moveStr] = tmpStr;
     }
 
     return listOfValidMoves;
@@ -60,6 +60,8 @@ void makeMove(Move &move)
     board.gameLine[board.endOfSearch].fiftyMove    = board.fiftyMove;
     board.gameLine[board.endOfSearch].epSquare     = board.epSquare;
     board.gameLine[board.endOfSearch].key          = board.hashkey;
+    board.gameLine[board.endOfSearch].pawnKey      = board.pawnkey;
+    board.gameLine[board.endOfSearch].materialKey  = board.materialkey;
 
     Bitboard fromBitboard  = BITSET[from];
     Bitboard fromToBitboard = fromBitboard  | BITSET[to];
@@ -75,6 +77,7 @@ void makeMove(Move &move)
             board.square[to]          = WHITE_PAWN;
             board.epSquare            = 0;
             board.fiftyMove           = 0;
+            board.pawnkey ^= (KEY.keys[from][piece] ^ KEY.keys[to][piece]);
             if ((RANKS[from] == 2) && (RANKS[to] == 4)) 
             { 
                 board.epSquare = from + 8;
@@ -91,6 +94,8 @@ void makeMove(Move &move)
                     board.totalBlackPawns     -= PAWN_VALUE;
                     board.Material           += PAWN_VALUE;
                     board.hashkey             ^= KEY.keys[to-8][BLACK_PAWN];   
+                    board.pawnkey             ^= KEY.keys[to-8][BLACK_PAWN];
+                    board.materialkey         -= MATERIAL_WEIGHT[BLACK_PAWN];
                 }
                 else
                 {
@@ -224,6 +229,7 @@ void makeMove(Move &move)
             board.square[to]          = BLACK_PAWN;
             board.epSquare            = 0;
             board.fiftyMove = 0;
+            board.pawnkey ^= (KEY.keys[from][piece] ^ KEY.keys[to][piece]);
             if ((RANKS[from] == 7) && (RANKS[to] == 5))
             {
                 board.epSquare = from - 8;                                        
@@ -240,6 +246,8 @@ void makeMove(Move &move)
                     board.totalWhitePawns     -= PAWN_VALUE;
                     board.Material           -= PAWN_VALUE;
                     board.hashkey             ^= KEY.keys[to+8][WHITE_PAWN]; 
+                    board.pawnkey             ^= KEY.keys[to+8][WHITE_PAWN];
+                    board.materialkey         -= MATERIAL_WEIGHT[WHITE_PAWN];
                 }
                 else
                 {
@@ -624,14 +632,144 @@ void unmakeMove(Move &move)
     board.epSquare            = board.gameLine[board.endOfSearch].epSquare;
     board.fiftyMove           = board.gameLine[board.endOfSearch].fiftyMove;
     board.hashkey             = board.gameLine[board.endOfSearch].key; 
+    board.pawnkey             = board.gameLine[board.endOfSearch].pawnKey;
+    board.materialkey         = board.gameLine[board.endOfSearch].materialKey;
 }
 
+
+
+// makeNullMove
+//
+// Pass the turn to the opponent (null move pruning). The state is saved in
+// gameLine like makeMove does. The en-passant square is cleared, since it is
+// only valid right after the double pawn move, and the fifty-move counter is
+// reset so that repetitions are not looked for across the null move.
+void makeNullMove()
+{
+    board.gameLine[board.endOfSearch].move.moveInt = 0;
+    board.gameLine[board.endOfSearch].castleWhite  = board.castleWhite;
+    board.gameLine[board.endOfSearch].castleBlack  = board.castleBlack;
+    board.gameLine[board.endOfSearch].fiftyMove    = board.fiftyMove;
+    board.gameLine[board.endOfSearch].epSquare     = board.epSquare;
+    board.gameLine[board.endOfSearch].key          = board.hashkey;
+    board.gameLine[board.endOfSearch].pawnKey      = board.pawnkey;
+    board.gameLine[board.endOfSearch].materialKey  = board.materialkey;
+
+    if (board.epSquare) board.hashkey ^= KEY.ep[board.epSquare];
+    board.epSquare  = 0;
+    board.fiftyMove = 0;
+
+    board.nextMove = !board.nextMove;
+    board.hashkey ^= KEY.side;
+    board.endOfSearch++;
+}
+
+
+
+// unmakeNullMove
+//
+// Take back the null move, restoring the state saved by makeNullMove.
+void unmakeNullMove()
+{
+    board.nextMove = !board.nextMove;
+
+    board.endOfSearch--;
+    board.epSquare            = board.gameLine[board.endOfSearch].epSquare;
+    board.fiftyMove           = board.gameLine[board.endOfSearch].fiftyMove;
+    board.hashkey             = board.gameLine[board.endOfSearch].key;
+}
+
+
+
+// keyAfterMove
+//
+// Return the hash key the board would have after the given move, without
+// making it. This applies the same KEY deltas that makeMove applies.
+uint64_t keyAfterMove(Move &move)
+{
+    int from = move.getFrom();
+    int to = move.getTosq();
+    unsigned int piece = move.getPiece();
+    unsigned int captured = move.getCapture();
+    unsigned char castleWhite = board.castleWhite;
+    unsigned char castleBlack = board.castleBlack;
+    uint64_t key;
+
+
+    // moving piece and side to move
+    key = board.hashkey ^ KEY.side ^ KEY.keys[from][piece] ^ KEY.keys[to][piece];
+
+
+    // en-passant square: the old one is gone, a double pawn move sets a new one
+    if (board.epSquare) key ^= KEY.ep[board.epSquare];
+    if ((piece == WHITE_PAWN) && (RANKS[from] == 2) && (RANKS[to] == 4)) key ^= KEY.ep[from + 8];
+    if ((piece == BLACK_PAWN) && (RANKS[from] == 7) && (RANKS[to] == 5)) key ^= KEY.ep[from - 8];
+
+
+    // captured piece (en-passant captures remove the pawn behind the target square)
+    if (captured)
+    {
+        if (move.isEnpassant())
+        {
+            if (piece == WHITE_PAWN)
+                key ^= KEY.keys[to-8][BLACK_PAWN];
+            else
+                key ^= KEY.keys[to+8][WHITE_PAWN];
+        }
+        else key ^= KEY.keys[to][captured];
+    }
+
+
+    // promotions replace the pawn on the target square
+    if (move.isPromo())
+        key ^= KEY.keys[to][piece] ^ KEY.keys[to][move.getPromo()];
+
+
+    // castling also moves the rook
+    if (move.isCastle())
+    {
+        if (piece == WHITE_KING)
+        {
+            if (move.isCastleOO())
+                key ^= KEY.keys[H1][WHITE_ROOK] ^ KEY.keys[F1][WHITE_ROOK];
+            else
+                key ^= KEY.keys[A1][WHITE_ROOK] ^ KEY.keys[D1][WHITE_ROOK];
+        }
+        else
+        {
+            if (move.isCastleOO())
+                key ^= KEY.keys[H8][BLACK_ROOK] ^ KEY.keys[F8][BLACK_ROOK];
+            else
+                key ^= KEY.keys[A8][BLACK_ROOK] ^ KEY.keys[D8][BLACK_ROOK];
+        }
+    }
+
+
+    // castling rights lost by moving the king or a rook, or by losing a rook
+    if (piece == WHITE_KING) castleWhite = 0;
+    if (piece == BLACK_KING) castleBlack = 0;
+    if (((piece == WHITE_ROOK) && (from == A1)) || ((captured == WHITE_ROOK) && (to == A1))) castleWhite &= ~CANCASTLEOOO;
+    if (((piece == WHITE_ROOK) && (from == H1)) || ((captured == WHITE_ROOK) && (to == H1))) castleWhite &= ~CANCASTLEOO;
+    if (((piece == BLACK_ROOK) && (from == A8)) || ((captured == BLACK_ROOK) && (to == A8))) castleBlack &= ~CANCASTLEOOO;
+    if (((piece == BLACK_ROOK) && (from == H8)) || ((captured == BLACK_ROOK) && (to == H8))) castleBlack &= ~CANCASTLEOO;
+
+    if ((board.castleWhite ^ castleWhite) & CANCASTLEOO)  key ^= KEY.wk;
+    if ((board.castleWhite ^ castleWhite) & CANCASTLEOOO) key ^= KEY.wq;
+    if ((board.castleBlack ^ castleBlack) & CANCASTLEOO)  key ^= KEY.bk;
+    if ((board.castleBlack ^ castleBlack) & CANCASTLEOOO) key ^= KEY.bq;
+
+    return key;
+}
+
+
+
 void makeCapture(unsigned int &captured, unsigned int &to)
 {
     // deals with all captures, except en-passant
     Bitboard toBitboard;
     toBitboard = BITSET[to];
     board.hashkey ^= KEY.keys[to][captured];
+    board.materialkey -= MATERIAL_WEIGHT[captured];
 
     switch (captured)
     {
@@ -640,6 +778,7 @@ void makeCapture(unsigned int &captured, unsigned int &to)
             board.whitePieces          ^= toBitboard;
             board.totalWhitePawns     -= PAWN_VALUE;
             board.Material           -= PAWN_VALUE;
+            board.pawnkey             ^= KEY.keys[to][WHITE_PAWN];
             break;
 
         case 2: // white king:
@@ -690,6 +829,7 @@ void makeCapture(unsigned int &captured, unsigned int &to)
             board.blackPieces          ^= toBitboard;
             board.totalBlackPawns     -= PAWN_VALUE;
             board.Material           += PAWN_VALUE;
+            board.pawnkey             ^= KEY.keys[to][BLACK_PAWN];
             break;
 
         case 10: // black king:
@@ -849,30 +989,40 @@ void makeWhitePromotion(unsigned int prom, unsigned int &to)
     board.totalWhitePawns -= PAWN_VALUE;
     board.Material -= PAWN_VALUE;
     board.hashkey ^= (KEY.keys[to][WHITE_PAWN] ^ KEY.keys[to][prom]);
+    board.pawnkey ^= KEY.keys[to][WHITE_PAWN];
+    board.materialkey += MATERIAL_WEIGHT[prom] - MATERIAL_WEIGHT[WHITE_PAWN];
 
     if (prom == 7)
     {
         board.whiteQueens          ^= toBitboard;
         board.totalWhitePieces    += QUEEN_VALUE;
         board.Material           += QUEEN_VALUE;
+        if (bitCnt(board.whiteQueens) > MATERIAL_MAX_QUEENS)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
     else if (prom == 6)
     {
         board.whiteRooks         ^= toBitboard;
         board.totalWhitePieces    += ROOK_VALUE;
         board.Material           += ROOK_VALUE;
+        if (bitCnt(board.whiteRooks) > MATERIAL_MAX_PIECES)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
     else if (prom == 5)
     {
         board.whiteBishops       ^= toBitboard;
         board.totalWhitePieces    += BISHOP_VALUE;
         board.Material           += BISHOP_VALUE;
+        if (bitCnt(board.whiteBishops) > MATERIAL_MAX_PIECES)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
     else if (prom == 3)
     {
         board.whiteKnights       ^= toBitboard;
         board.totalWhitePieces    += KNIGHT_VALUE;
         board.Material           += KNIGHT_VALUE;
+        if (bitCnt(board.whiteKnights) > MATERIAL_MAX_PIECES)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
 }
 
@@ -921,30 +1071,40 @@ void makeBlackPromotion(unsigned int prom, unsigned int &to)
     board.totalBlackPawns -= PAWN_VALUE;
     board.Material += PAWN_VALUE;
     board.hashkey ^= (KEY.keys[to][BLACK_PAWN] ^ KEY.keys[to][prom]);
+    board.pawnkey ^= KEY.keys[to][BLACK_PAWN];
+    board.materialkey += MATERIAL_WEIGHT[prom] - MATERIAL_WEIGHT[BLACK_PAWN];
 
     if (prom == 15)
     {
         board.blackQueens          ^= toBitboard;
         board.totalBlackPieces    += QUEEN_VALUE;
         board.Material           -= QUEEN_VALUE;
+        if (bitCnt(board.blackQueens) > MATERIAL_MAX_QUEENS)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
     else if (prom == 14)
     {
         board.blackRooks         ^= toBitboard;
         board.totalBlackPieces    += ROOK_VALUE;
         board.Material           -= ROOK_VALUE;
+        if (bitCnt(board.blackRooks) > MATERIAL_MAX_PIECES)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
     else if (prom == 13)
     {
         board.blackBishops       ^= toBitboard;
         board.totalBlackPieces    += BISHOP_VALUE;
         board.Material           -= BISHOP_VALUE;
+        if (bitCnt(board.blackBishops) > MATERIAL_MAX_PIECES)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
     else if (prom == 11)
     {
         board.blackKnights       ^= toBitboard;
         board.totalBlackPieces    += KNIGHT_VALUE;
         board.Material           -= KNIGHT_VALUE;
+        if (bitCnt(board.blackKnights) > MATERIAL_MAX_PIECES)
+            board.materialkey |= MATERIAL_OVERFLOW;
     }
 }
 
@@ -0,0 +1,187 @@
+// This file is part of Chess0, a computer chess program based on Winglet chess
+// by Stef Luijten.
+//
+// Copyright (C) 2022 Claudio M. Camacho
+//
+// Chess0 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Chess0 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Foobar. If not, see <http://www.gnu.org/licenses/>.
+
+
+// @file material.cpp
+//
+// This file contains the functions to build and probe the material signature
+// table, which replaces counting pieces in the evaluation function.
+#include "definitions.h"
+#include "functions.h"
+#include "extglobals.h"
+
+
+
+// evalMaterial
+//
+// Fill in a materialEntry for the given piece counts. The draw rules and the
+// exchange bonus are the ones Board::eval and Board::isEndOfgame used to
+// compute on every call.
+static void evalMaterial(materialEntry &m, int wp, int wn, int wb, int wr, int wq,
+                         int bp, int bn, int bb, int br, int bq)
+{
+    int whitetotalmat = 3 * wn + 3 * wb + 5 * wr + 10 * wq;
+    int blacktotalmat = 3 * bn + 3 * bb + 5 * br + 10 * bq;
+    int whitetotal = wp + wn + wb + wr + wq;
+    int blacktotal = bp + bn + bb + br + bq;
+
+
+    m.whitePawns = wp; m.whiteKnights = wn; m.whiteBishops = wb; m.whiteRooks = wr; m.whiteQueens = wq;
+    m.blackPawns = bp; m.blackKnights = bn; m.blackBishops = bb; m.blackRooks = br; m.blackQueens = bq;
+
+
+    // 1. endgame: anything less than a queen + rook (=15), excluding pawns
+    m.endgame = (whitetotalmat < 15 || blacktotalmat < 15);
+
+
+    // 2. draws due to insufficient material
+    m.evalDraw = MATERIAL_NO_DRAW;
+    m.gameDraw = MATERIAL_NO_DRAW;
+    if (!wp && !bp)
+    {
+        // 2.1 only bishops left: draw if they are all on the same color
+        if ((wb + bb) > 0 && !wn && !wr && !wq && !bn && !br && !bq)
+        {
+            m.evalDraw = MATERIAL_BISHOP_DRAW;
+            m.gameDraw = MATERIAL_BISHOP_DRAW;
+        }
+
+        // 2.2 K-K, KN-K and Kminor-Kminor cannot be won
+        if (((whitetotalmat == 0) && (blacktotalmat == 0)) ||
+            ((whitetotalmat == 3) && (wn == 1) && (blacktotalmat == 0)) ||
+            ((blacktotalmat == 3) && (bn == 1) && (whitetotalmat == 0)) ||
+            ((whitetotalmat == 3) && (blacktotalmat == 3)))
+        {
+            m.evalDraw = MATERIAL_DRAW;
+            m.gameDraw = MATERIAL_DRAW;
+        }
+
+        // 2.3 KNN-K, KNN-Kminor, KBB-KB and KBN-Kminor are evaluated as draws
+        if (((whitetotalmat == 6) && (wn == 2) && (blacktotalmat <= 3)) ||
+            ((blacktotalmat == 6) && (bn == 2) && (whitetotalmat <= 3)) ||
+            ((whitetotalmat == 6) && (wb >= 1) && (blacktotalmat == 3)) ||
+            ((blacktotalmat == 6) && (bb >= 1) && (whitetotalmat == 3)))
+        {
+            m.evalDraw = MATERIAL_DRAW;
+        }
+    }
+
+
+    // 3. the winning side prefers to exchange pieces
+    // (every exchange with unequal material adds 8 centipawns to the score)
+    m.imbalance = 0;
+    if (whitetotalmat + wp > blacktotalmat + bp)
+        m.imbalance =  45 + 3 * whitetotal - 8 * blacktotal;
+    else if (whitetotalmat + wp < blacktotalmat + bp)
+        m.imbalance = -45 - 3 * blacktotal + 8 * whitetotal;
+}
+
+
+
+// materialInit
+//
+// Set up the weight of every piece in the material key and precompute the
+// material signature table. Called once at startup.
+void materialInit()
+{
+    int wp, wn, wb, wr, wq, bp, bn, bb, br, bq;
+
+
+    // the material key is a mixed-radix number with one digit per piece type
+    for (int i = 0; i < 16; i++) MATERIAL_WEIGHT[i] = 0;
+    MATERIAL_WEIGHT[WHITE_PAWN]   = 1;
+    MATERIAL_WEIGHT[WHITE_KNIGHT] = MATERIAL_WEIGHT[WHITE_PAWN]   * (MATERIAL_MAX_PAWNS + 1);
+    MATERIAL_WEIGHT[WHITE_BISHOP] = MATERIAL_WEIGHT[WHITE_KNIGHT] * (MATERIAL_MAX_PIECES + 1);
+    MATERIAL_WEIGHT[WHITE_ROOK]   = MATERIAL_WEIGHT[WHITE_BISHOP] * (MATERIAL_MAX_PIECES + 1);
+    MATERIAL_WEIGHT[WHITE_QUEEN]  = MATERIAL_WEIGHT[WHITE_ROOK]   * (MATERIAL_MAX_PIECES + 1);
+    MATERIAL_WEIGHT[BLACK_PAWN]   = MATERIAL_WEIGHT[WHITE_QUEEN]  * (MATERIAL_MAX_QUEENS + 1);
+    MATERIAL_WEIGHT[BLACK_KNIGHT] = MATERIAL_WEIGHT[BLACK_PAWN]   * (MATERIAL_MAX_PAWNS + 1);
+    MATERIAL_WEIGHT[BLACK_BISHOP] = MATERIAL_WEIGHT[BLACK_KNIGHT] * (MATERIAL_MAX_PIECES + 1);
+    MATERIAL_WEIGHT[BLACK_ROOK]   = MATERIAL_WEIGHT[BLACK_BISHOP] * (MATERIAL_MAX_PIECES + 1);
+    MATERIAL_WEIGHT[BLACK_QUEEN]  = MATERIAL_WEIGHT[BLACK_ROOK]   * (MATERIAL_MAX_PIECES + 1);
+
+
+    // walk all the digits, the key of every combination is its index
+    for (unsigned int key = 0; key < MATERIAL_TABLE_SIZE; key++)
+    {
+        unsigned int k = key;
+        wp = k % (MATERIAL_MAX_PAWNS + 1);  k /= (MATERIAL_MAX_PAWNS + 1);
+        wn = k % (MATERIAL_MAX_PIECES + 1); k /= (MATERIAL_MAX_PIECES + 1);
+        wb = k % (MATERIAL_MAX_PIECES + 1); k /= (MATERIAL_MAX_PIECES + 1);
+        wr = k % (MATERIAL_MAX_PIECES + 1); k /= (MATERIAL_MAX_PIECES + 1);
+        wq = k % (MATERIAL_MAX_QUEENS + 1); k /= (MATERIAL_MAX_QUEENS + 1);
+        bp = k % (MATERIAL_MAX_PAWNS + 1);  k /= (MATERIAL_MAX_PAWNS + 1);
+        bn = k % (MATERIAL_MAX_PIECES + 1); k /= (MATERIAL_MAX_PIECES + 1);
+        bb = k % (MATERIAL_MAX_PIECES + 1); k /= (MATERIAL_MAX_PIECES + 1);
+        br = k % (MATERIAL_MAX_PIECES + 1); k /= (MATERIAL_MAX_PIECES + 1);
+        bq = k;
+
+        evalMaterial(MATERIAL[key], wp, wn, wb, wr, wq, bp, bn, bb, br, bq);
+    }
+}
+
+
+
+// materialKey
+//
+// Compute the material key of the current board from scratch. If any piece
+// count does not fit in the table (e.g., after an underpromotion to a third
+// knight) the key is flagged with MATERIAL_OVERFLOW.
+unsigned int materialKey()
+{
+    unsigned int key;
+    int wp = bitCnt(board.whitePawns), wn = bitCnt(board.whiteKnights), wb = bitCnt(board.whiteBishops);
+    int wr = bitCnt(board.whiteRooks), wq = bitCnt(board.whiteQueens);
+    int bp = bitCnt(board.blackPawns), bn = bitCnt(board.blackKnights), bb = bitCnt(board.blackBishops);
+    int br = bitCnt(board.blackRooks), bq = bitCnt(board.blackQueens);
+
+
+    key = wp * MATERIAL_WEIGHT[WHITE_PAWN] + wn * MATERIAL_WEIGHT[WHITE_KNIGHT] +
+          wb * MATERIAL_WEIGHT[WHITE_BISHOP] + wr * MATERIAL_WEIGHT[WHITE_ROOK] +
+          wq * MATERIAL_WEIGHT[WHITE_QUEEN] + bp * MATERIAL_WEIGHT[BLACK_PAWN] +
+          bn * MATERIAL_WEIGHT[BLACK_KNIGHT] + bb * MATERIAL_WEIGHT[BLACK_BISHOP] +
+          br * MATERIAL_WEIGHT[BLACK_ROOK] + bq * MATERIAL_WEIGHT[BLACK_QUEEN];
+
+    if ((wp > MATERIAL_MAX_PAWNS) || (wn > MATERIAL_MAX_PIECES) || (wb > MATERIAL_MAX_PIECES) ||
+        (wr > MATERIAL_MAX_PIECES) || (wq > MATERIAL_MAX_QUEENS) ||
+        (bp > MATERIAL_MAX_PAWNS) || (bn > MATERIAL_MAX_PIECES) || (bb > MATERIAL_MAX_PIECES) ||
+        (br > MATERIAL_MAX_PIECES) || (bq > MATERIAL_MAX_QUEENS))
+        key |= MATERIAL_OVERFLOW;
+
+    return key;
+}
+
+
+
+// probeMaterial
+//
+// Return the material signature entry for the current board. Positions whose
+// piece counts do not fit in the table are evaluated on the fly into the given
+// scratch entry.
+const materialEntry *probeMaterial(materialEntry &scratch)
+{
+    if (board.materialkey < MATERIAL_TABLE_SIZE)
+        return &MATERIAL[board.materialkey];
+
+    evalMaterial(scratch, bitCnt(board.whitePawns), bitCnt(board.whiteKnights), bitCnt(board.whiteBishops),
+                 bitCnt(board.whiteRooks), bitCnt(board.whiteQueens), bitCnt(board.blackPawns),
+                 bitCnt(board.blackKnights), bitCnt(board.blackBishops), bitCnt(board.blackRooks),
+                 bitCnt(board.blackQueens));
+
+    return &scratch;
+}
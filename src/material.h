@@ -0,0 +1,60 @@
+// This file is part of Chess0, a computer chess program based on Winglet chess
+// by Stef Luijten.
+//
+// Copyright (C) 2022 Claudio M. Camacho
+//
+// Chess0 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Chess0 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Foobar. If not, see <http://www.gnu.org/licenses/>.
+
+
+// @file material.h
+//
+// This file describes the material signature table. Every combination of piece
+// counts (up to 8 pawns, 2 knights, 2 bishops, 2 rooks and 1 queen per side)
+// has its own entry, indexed by the material key that makeMove and unmakeMove
+// keep up to date in Board::materialkey.
+#ifndef _MATERIAL_H_
+#define _MATERIAL_H_
+
+
+#include <stdint.h>
+
+
+
+// Draw verdicts stored in a materialEntry:
+//  - MATERIAL_NO_DRAW: there is enough material to win
+//  - MATERIAL_DRAW: the material on board is a draw
+//  - MATERIAL_BISHOP_DRAW: only bishops are left, it is a draw if they are
+//                          all on squares of the same color
+enum materialVerdict
+{
+    MATERIAL_NO_DRAW     = 0,
+    MATERIAL_DRAW        = 1,
+    MATERIAL_BISHOP_DRAW = 2,
+};
+
+
+
+struct materialEntry
+{
+    int8_t  whitePawns, whiteKnights, whiteBishops, whiteRooks, whiteQueens;
+    int8_t  blackPawns, blackKnights, blackBishops, blackRooks, blackQueens;
+    bool    endgame;                    // less than queen + rook on either side
+    uint8_t evalDraw;                   // draw verdict used by Board::eval
+    uint8_t gameDraw;                   // insufficient material to end the game
+    int16_t imbalance;                  // exchange bonus, from White's side
+};
+
+
+
+#endif // _MATERIAL_H_
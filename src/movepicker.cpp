@@ -0,0 +1,272 @@
+// This file is part of Chess0, a computer chess program based on Winglet chess
+// by Stef Luijten.
+//
+// Copyright (C) 2022 Claudio M. Camacho
+//
+// Chess0 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Chess0 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Foobar. If not, see <http://www.gnu.org/licenses/>.
+
+
+
+// @file movepicker.cpp
+//
+// This file contains the staged move picker used by the main search.
+#include "definitions.h"
+#include "functions.h"
+#include "extglobals.h"
+#include "movepicker.h"
+
+
+
+// MovePicker
+//
+// Prepare to pick the moves of the node at the given ply. The PV move and the
+// hash move (either may be empty) are tried before any move is generated.
+MovePicker::MovePicker(int p, Move pv, Move hash)
+{
+    ply        = p;
+    stage      = PICK_PV;
+    killer     = 0;
+    captures   = captEnd = badCapture = quiets = 0;
+    pvMove     = pv;
+    hashMove   = hash;
+
+    if (hashMove.moveInt == pvMove.moveInt)
+        hashMove.moveInt = 0;
+
+    board.moveBufLen[ply+1] = board.moveBufLen[ply];
+    setLegalMasks(masks);
+}
+
+
+
+// MovePicker::add
+//
+// Append a move that was not generated (PV, hash or killer move) to the moves
+// of this node, and return its index in the move buffer.
+int MovePicker::add(Move &move)
+{
+    int i = board.moveBufLen[ply+1]++;
+
+    board.moveBuffer[i] = move;
+    return i;
+}
+
+
+
+// MovePicker::tried
+//
+// Tell whether a generated move was already handed out before generating it.
+bool MovePicker::tried(Move &move)
+{
+    return (move.moveInt == pvMove.moveInt) || (move.moveInt == hashMove.moveInt) ||
+           (move.moveInt == board.ss[ply].killers[0].moveInt) ||
+           (move.moveInt == board.ss[ply].killers[1].moveInt);
+}
+
+
+
+// MovePicker::genEvasions
+//
+// Generate the check evasions (see evasiongen) at once, and split them like the
+// other stages would: captures and promotions first, sorted by SEE, followed
+// by the quiet moves that were not tried yet, with their history score.
+// Either may be empty, and the moves are handed out by the usual stages.
+void MovePicker::genEvasions()
+{
+    int i, j, end, val;
+    unsigned int (*heuristics)[64] = board.nextMove ? board.blackHeuristics : board.whiteHeuristics;
+    Move temp;
+
+    captures = captEnd = board.moveBufLen[ply+1];
+    end = evasiongen(captures, masks);
+
+    // move the captures to the front, keeping them sorted by SEE
+    for (i = captures; i < end; i++)
+    {
+        if (!board.moveBuffer[i].isCapture() && !board.moveBuffer[i].isPromo())
+            continue;
+
+        temp = board.moveBuffer[i];
+        board.moveBuffer[i] = board.moveBuffer[captEnd];
+        val = board.SEE(temp);
+        for (j = captEnd; (j > captures) && (score[j - captures - 1] < val); j--)
+        {
+            board.moveBuffer[j] = board.moveBuffer[j-1];
+            score[j - captures] = score[j - captures - 1];
+        }
+        board.moveBuffer[j] = temp;
+        score[j - captures] = val;
+        captEnd++;
+    }
+
+    // and keep the quiet moves after them (the killers are not tried apart)
+    quiets = board.moveBufLen[ply+1] = captEnd;
+    for (i = captEnd; i < end; i++)
+    {
+        Move &m = board.moveBuffer[i];
+
+        if ((m.moveInt == pvMove.moveInt) || (m.moveInt == hashMove.moveInt))
+            continue;
+
+        board.moveBuffer[board.moveBufLen[ply+1]] = m;
+        score[board.moveBufLen[ply+1] - captures] = heuristics[m.getFrom()][m.getTosq()];
+        board.moveBufLen[ply+1]++;
+    }
+}
+
+
+
+// MovePicker::next
+//
+// Return the index in the move buffer of the next move to search, or -1 when
+// there are no moves left. Only legal moves are returned.
+int MovePicker::next()
+{
+    int i, j, best;
+    Move temp;
+
+
+    switch (stage)
+    {
+        // 1. PV and hash moves, without generating anything
+        case PICK_PV:
+            stage = PICK_HASH;
+            if (pvMove.moveInt && isPseudoLegal(pvMove) && isLegal(pvMove, masks))
+                return add(pvMove);
+            pvMove.moveInt = 0;
+            [[fallthrough]];
+
+        case PICK_HASH:
+            stage = PICK_GEN_CAPTURES;
+            if (hashMove.moveInt && isPseudoLegal(hashMove) && isLegal(hashMove, masks))
+                return add(hashMove);
+            hashMove.moveInt = 0;
+            [[fallthrough]];
+
+
+        // 2. captures and promotions, sorted by SEE (the scores are left by
+        //    captgen() OFFSET moves past each move), without the illegal ones;
+        //    when in check, all the evasions are generated here instead
+        case PICK_GEN_CAPTURES:
+            if (masks.checkers)
+            {
+                genEvasions();
+            }
+            else
+            {
+                captures = board.moveBufLen[ply+1];
+                j = captgen(captures, -LARGE_NUMBER);
+                for (i = captEnd = captures; i < j; i++)
+                {
+                    if (isLegal(board.moveBuffer[i], masks))
+                    {
+                        score[captEnd - captures] = board.moveBuffer[i + OFFSET].moveInt;
+                        board.moveBuffer[captEnd++] = board.moveBuffer[i];
+                    }
+                }
+                board.moveBufLen[ply+1] = captEnd;
+            }
+            badCapture = captures;
+            stage = PICK_GOOD_CAPTURES;
+            [[fallthrough]];
+
+        case PICK_GOOD_CAPTURES:
+            while ((badCapture < captEnd) && (score[badCapture - captures] >= 0))
+            {
+                i = badCapture++;
+                if ((board.moveBuffer[i].moveInt != pvMove.moveInt) &&
+                    (board.moveBuffer[i].moveInt != hashMove.moveInt))
+                    return i;
+            }
+            stage = PICK_KILLERS;
+            [[fallthrough]];
+
+
+        // 3. killer moves, if they are quiet moves in this position (when in
+        //    check, they are sorted along with the other evasions instead)
+        case PICK_KILLERS:
+            while ((killer < 2) && !masks.checkers)
+            {
+                Move &k = board.ss[ply].killers[killer++];
+
+                if (k.moveInt && (k.moveInt != pvMove.moveInt) && (k.moveInt != hashMove.moveInt) &&
+                    !k.isCapture() && !k.isPromo() && isPseudoLegal(k) && isLegal(k, masks))
+                    return add(k);
+            }
+            stage = PICK_GEN_QUIETS;
+            [[fallthrough]];
+
+
+        // 4. generate all the moves and keep the legal quiet ones that were not
+        //    tried yet, with their history score
+        case PICK_GEN_QUIETS:
+            stage = PICK_QUIETS;
+            if (!masks.checkers)
+            {
+                unsigned int (*heuristics)[64] = board.nextMove ? board.blackHeuristics : board.whiteHeuristics;
+
+                quiets = board.moveBufLen[ply+1];
+                j = movegen(quiets);
+                for (i = quiets; i < j; i++)
+                {
+                    Move &m = board.moveBuffer[i];
+
+                    if (m.isCapture() || m.isPromo() || tried(m) || !isLegal(m, masks))
+                        continue;
+
+                    board.moveBuffer[board.moveBufLen[ply+1]] = m;
+                    score[board.moveBufLen[ply+1] - captures] = heuristics[m.getFrom()][m.getTosq()];
+                    board.moveBufLen[ply+1]++;
+                }
+            }
+            [[fallthrough]];
+
+        case PICK_QUIETS:
+            j = board.moveBufLen[ply+1];
+            if (quiets < j)
+            {
+                best = quiets;
+                for (i = quiets + 1; i < j; i++)
+                {
+                    if (score[i - captures] > score[best - captures])
+                        best = i;
+                }
+
+                temp = board.moveBuffer[best];
+                board.moveBuffer[best] = board.moveBuffer[quiets];
+                board.moveBuffer[quiets] = temp;
+                score[best - captures] = score[quiets - captures];
+
+                return quiets++;
+            }
+            stage = PICK_BAD_CAPTURES;
+            [[fallthrough]];
+
+
+        // 5. captures that lose material
+        case PICK_BAD_CAPTURES:
+            while (badCapture < captEnd)
+            {
+                i = badCapture++;
+                if ((board.moveBuffer[i].moveInt != pvMove.moveInt) &&
+                    (board.moveBuffer[i].moveInt != hashMove.moveInt))
+                    return i;
+            }
+            stage = PICK_DONE;
+            [[fallthrough]];
+
+        default:
+            return -1;
+    }
+}
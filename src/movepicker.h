@@ -0,0 +1,90 @@
+// This file is part of Chess0, a computer chess program based on Winglet chess
+// by Stef Luijten.
+//
+// Copyright (C) 2022 Claudio M. Camacho
+//
+// Chess0 is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Chess0 is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Foobar. If not, see <http://www.gnu.org/licenses/>.
+
+
+
+// @file movepicker.h
+//
+// This file describes the move picker, which hands out the moves of a node of
+// Board::alphabetapvs one at a time, generating them in stages. Most nodes fail
+// high on the first move or two, so the moves that are likely to cut come
+// first and the quiet moves are only generated if they are needed.
+#ifndef _MOVEPICKER_H_
+#define _MOVEPICKER_H_
+
+
+#include "definitions.h"
+#include "board.h"
+#include "move.h"
+
+
+
+// Stages of the move picker, in the order they are tried:
+//  - PICK_PV:            move of the previous principal variation
+//  - PICK_HASH:          move from the transposition table
+//  - PICK_GEN_CAPTURES:  generate captures and promotions, sorted by SEE (or
+//                        all the check evasions, if in check)
+//  - PICK_GOOD_CAPTURES: captures that do not lose material
+//  - PICK_KILLERS:       killer moves of the ply
+//  - PICK_GEN_QUIETS:    generate the rest of the moves (already done when
+//                        evading a check)
+//  - PICK_QUIETS:        quiet moves, by their history heuristics
+//  - PICK_BAD_CAPTURES:  captures that lose material
+enum pickStage
+{
+    PICK_PV,
+    PICK_HASH,
+    PICK_GEN_CAPTURES,
+    PICK_GOOD_CAPTURES,
+    PICK_KILLERS,
+    PICK_GEN_QUIETS,
+    PICK_QUIETS,
+    PICK_BAD_CAPTURES,
+    PICK_DONE,
+};
+
+
+
+// The moves are stored in Board::moveBuffer, from moveBufLen[ply] onwards, and
+// moveBufLen[ply+1] is moved forward as the stages generate them, so that the
+// child nodes always generate their moves after the ones of this node.
+class MovePicker
+{
+    private:
+        int  ply;
+        int  stage;
+        int  killer;                    // next killer slot to try
+        int  captures, captEnd;         // range of the generated captures
+        int  badCapture;                // first capture that loses material
+        int  quiets;                    // first generated quiet move
+        Move pvMove, hashMove;
+        LegalMasks masks;               // to keep only the legal moves
+        int  score[MAX_MOVES];          // sort keys of the generated moves
+
+        int  add(Move &);
+        bool tried(Move &);
+        void genEvasions();
+
+    public:
+        MovePicker(int ply, Move pv, Move hash);
+        int  next();
+};
+
+
+
+#endif // _MOVEPICKER_H_
@@ -429,8 +429,8 @@ int movegen(int index)
 // and the new first free location is returned.
 //  
 // This function keeps the move list sorted (using SEE) and shortens 
-// the list by discarding 'bad' moves. 
-int captgen(int index)
+// the list by discarding the moves that score less than minScore.
+int captgen(int index, int minScore)
 {
     unsigned char opponentSide;
     unsigned int from, to;
@@ -468,23 +468,23 @@ int captgen(int index)
                 if ((RANKS[to]) == 1)
                 {
                     move.setPromo(BLACK_QUEEN);      board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(BLACK_ROOK);       board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(BLACK_BISHOP);     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(BLACK_KNIGHT);     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(EMPTY);
                 }
                 else
                 {
                     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                 }
                 tempMove ^= BITSET[to];
@@ -497,7 +497,7 @@ int captgen(int index)
                     move.setCapture(WHITE_PAWN);
                     move.setTosq(board.epSquare);
                     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                 }
             }
@@ -520,7 +520,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -542,7 +542,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -563,7 +563,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -585,7 +585,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -607,7 +607,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             } 
@@ -640,23 +640,23 @@ int captgen(int index)
                 if ((RANKS[to]) == 8)
                 {
                     move.setPromo(WHITE_QUEEN);      board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(WHITE_ROOK);       board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(WHITE_BISHOP);     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(WHITE_KNIGHT);     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                     move.setPromo(EMPTY);
                 }
                 else
                 {
                     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                 }
                 tempMove ^= BITSET[to];
@@ -669,7 +669,7 @@ int captgen(int index)
                     move.setCapture(BLACK_PAWN);
                     move.setTosq(board.epSquare);
                     board.moveBuffer[index].moveInt = move.moveInt;
-                    board.addCaptScore(ifirst,index);
+                    board.addCaptScore(ifirst, index, minScore);
                     index++;
                 }
             }
@@ -693,7 +693,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -716,7 +716,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -739,7 +739,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -762,7 +762,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst,index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             }
@@ -785,7 +785,7 @@ int captgen(int index)
                 move.setTosq(to);
                 move.setCapture(board.square[to]);
                 board.moveBuffer[index].moveInt = move.moveInt;
-                board.addCaptScore(ifirst, index);
+                board.addCaptScore(ifirst, index, minScore);
                 index++;
                 tempMove ^= BITSET[to];
             } 
@@ -879,10 +879,417 @@ bool isAttacked(Bitboard &targetBitmap, const unsigned char &fromSide)
 
 
 
+// isPseudoLegal
+//
+// Tell whether a move that was not generated in this position (e.g. the move
+// from the transposition table, or a killer move from a sibling node) is one of
+// the moves that movegen() would generate, so that it is safe to make it.
+bool isPseudoLegal(Move &move)
+{
+    unsigned int from, to, promo;
+    int piece, capt;
+    Bitboard targetBitmap, ownPieces, freeSquares, tempMove;
+
+    // castling: same checks as movegen()
+    if (move.isCastle())
+    {
+        if (board.nextMove)
+        {
+            if ((unsigned int) move.moveInt == BLACK_OO_CASTL)
+                return (board.castleBlack & CANCASTLEOO) && !(maskFG[1] & board.occupiedSquares) &&
+                       !isAttacked(maskEG[BLACK_MOVE], WHITE_MOVE);
+            if ((unsigned int) move.moveInt == BLACK_OOO_CASTL)
+                return (board.castleBlack & CANCASTLEOOO) && !(maskBD[1] & board.occupiedSquares) &&
+                       !isAttacked(maskCE[BLACK_MOVE], WHITE_MOVE);
+        }
+        else
+        {
+            if ((unsigned int) move.moveInt == WHITE_OO_CASTL)
+                return (board.castleWhite & CANCASTLEOO) && !(maskFG[0] & board.occupiedSquares) &&
+                       !isAttacked(maskEG[WHITE_MOVE], BLACK_MOVE);
+            if ((unsigned int) move.moveInt == WHITE_OOO_CASTL)
+                return (board.castleWhite & CANCASTLEOOO) && !(maskBD[0] & board.occupiedSquares) &&
+                       !isAttacked(maskCE[WHITE_MOVE], BLACK_MOVE);
+        }
+        return false;
+    }
+
+    from  = move.getFrom();
+    to    = move.getTosq();
+    piece = move.getPiece();
+    capt  = move.getCapture();
+    promo = move.getPromo();
+
+    // the piece must be on its square, and belong to the side to move
+    if ((piece == EMPTY) || (board.square[from] != piece) || (move.isBlackMove() != (bool) board.nextMove))
+        return false;
+
+    ownPieces   = board.nextMove ? board.blackPieces : board.whitePieces;
+    freeSquares = ~board.occupiedSquares;
+    targetBitmap = ~ownPieces;
+
+    // en-passant captures
+    if (move.isEnpassant())
+    {
+        if (!board.epSquare || (to != (unsigned int) board.epSquare))
+            return false;
+        if (board.nextMove)
+            return (piece == BLACK_PAWN) && (capt == WHITE_PAWN) && (BLACK_PAWN_ATTACKS[from] & BITSET[to]) &&
+                   (board.whitePawns & BITSET[to + 8]);
+        return (piece == WHITE_PAWN) && (capt == BLACK_PAWN) && (WHITE_PAWN_ATTACKS[from] & BITSET[to]) &&
+               (board.blackPawns & BITSET[to - 8]);
+    }
+
+    // the captured piece must be on the target square (or none at all)
+    if ((board.square[to] != capt) || (BITSET[to] & ownPieces))
+        return false;
+
+    // pawns: pushes, double pushes and captures, with a promotion on the last rank
+    if (move.isPawnMove())
+    {
+        if (board.nextMove)
+        {
+            tempMove = BLACK_PAWN_MOVES[from] & freeSquares;
+            if (RANKS[from] == 7 && tempMove)
+                tempMove |= (BLACK_PAWN_DOUBLE_MOVES[from] & freeSquares);
+            tempMove |= BLACK_PAWN_ATTACKS[from] & board.whitePieces;
+            if (RANKS[to] == 1)
+                return (tempMove & BITSET[to]) && ((promo == BLACK_QUEEN) || (promo == BLACK_ROOK) ||
+                                                   (promo == BLACK_BISHOP) || (promo == BLACK_KNIGHT));
+        }
+        else
+        {
+            tempMove = WHITE_PAWN_MOVES[from] & freeSquares;
+            if (RANKS[from] == 2 && tempMove)
+                tempMove |= (WHITE_PAWN_DOUBLE_MOVES[from] & freeSquares);
+            tempMove |= WHITE_PAWN_ATTACKS[from] & board.blackPieces;
+            if (RANKS[to] == 8)
+                return (tempMove & BITSET[to]) && ((promo == WHITE_QUEEN) || (promo == WHITE_ROOK) ||
+                                                   (promo == WHITE_BISHOP) || (promo == WHITE_KNIGHT));
+        }
+        return (tempMove & BITSET[to]) && (promo == EMPTY);
+    }
+
+    if (promo != EMPTY)
+        return false;
+
+    // pieces
+    if (move.isKingMove())
+        tempMove = KING_ATTACKS[from] & targetBitmap;
+    else if ((piece == WHITE_KNIGHT) || (piece == BLACK_KNIGHT))
+        tempMove = KNIGHT_ATTACKS[from] & targetBitmap;
+    else if ((piece == WHITE_BISHOP) || (piece == BLACK_BISHOP))
+        tempMove = BISHOPMOVES(from);
+    else if ((piece == WHITE_ROOK) || (piece == BLACK_ROOK))
+        tempMove = ROOKMOVES(from);
+    else
+        tempMove = QUEENMOVES(from);
+
+    return (tempMove & BITSET[to]) != 0;
+}
+
+
+
+// setLegalMasks
+//
+// Find the pieces giving check to the side to move and the pieces pinned to
+// its king, so that isLegal() can tell the legal moves apart without making
+// them.
+void setLegalMasks(LegalMasks &masks)
+{
+    int sq;
+    Bitboard ownPieces, rooks, bishops, candidates, between;
+
+    if (board.nextMove)
+    {
+        masks.king     = firstOne(board.blackKing);
+        ownPieces      = board.blackPieces;
+        rooks          = board.whiteRooks | board.whiteQueens;
+        bishops        = board.whiteBishops | board.whiteQueens;
+        masks.checkers = board.attacksTo(masks.king) & board.whitePieces;
+    }
+    else
+    {
+        masks.king     = firstOne(board.whiteKing);
+        ownPieces      = board.whitePieces;
+        rooks          = board.blackRooks | board.blackQueens;
+        bishops        = board.blackBishops | board.blackQueens;
+        masks.checkers = board.attacksTo(masks.king) & board.blackPieces;
+    }
+
+    // with one checker, it has to be captured or blocked
+    masks.evasions = ~0ULL;
+    if (masks.checkers)
+        masks.evasions = masks.checkers | BETWEEN[masks.king][firstOne(masks.checkers)];
+
+    // a piece is pinned if it is the only one between its king and an opponent
+    // slider that would attack the king on an empty board
+    masks.pinned = 0;
+    candidates = ((RANK_ATTACKS[masks.king][0] | FILE_ATTACKS[masks.king][0]) & rooks) |
+                 ((DIAGA8H1_ATTACKS[masks.king][0] | DIAGA1H8_ATTACKS[masks.king][0]) & bishops);
+    while (candidates)
+    {
+        sq = firstOne(candidates);
+        between = BETWEEN[masks.king][sq] & board.occupiedSquares;
+        if (between && !(between & (between - 1)) && (between & ownPieces))
+            masks.pinned |= between;
+        candidates ^= BITSET[sq];
+    }
+}
+
+
+
+// isLegal
+//
+// Tell whether a pseudo-legal move leaves the own king out of check, using the
+// masks of the position (see setLegalMasks). Only en-passant captures, which
+// can uncover an attack along the rank of both pawns, are made to find out.
+bool isLegal(Move &move, LegalMasks &masks)
+{
+    unsigned int from, to;
+    bool attacked;
+
+    from = move.getFrom();
+    to   = move.getTosq();
+
+    // the king cannot move to an attacked square, including the ones that it
+    // hides from a slider while standing on its current square (movegen only
+    // castles through and to squares that are not attacked)
+    if (move.isKingMove())
+    {
+        if (move.isCastle())
+            return true;
+
+        board.occupiedSquares ^= BITSET[from];
+        attacked = isAttacked(BITSET[to], !board.nextMove);
+        board.occupiedSquares ^= BITSET[from];
+        return !attacked;
+    }
+
+    // in double check, only the king can move
+    if (masks.checkers & (masks.checkers - 1))
+        return false;
+
+    if (move.isEnpassant())
+    {
+        makeMove(move);
+        attacked = isOtherKingAttacked();
+        unmakeMove(move);
+        return !attacked;
+    }
+
+    if (!(masks.evasions & BITSET[to]))
+        return false;
+
+    return !(masks.pinned & BITSET[from]) || (LINE[masks.king][from] & BITSET[to]);
+}
+
+
+
+// legalgen
+//
+// Legal move generator: generate the pseudo-legal moves with movegen() and
+// keep only the legal ones, using the check and pin masks of the position.
+// When in check, the evasions are generated directly (see evasiongen).
+// The first free location in moveBuffer[] is supplied in index, and the new
+// first free location is returned.
+int legalgen(int index)
+{
+    int i, last;
+    LegalMasks masks;
+
+    setLegalMasks(masks);
+    if (masks.checkers)
+        return evasiongen(index, masks);
+
+    last = movegen(index);
+    for (i = index; i < last; i++)
+    {
+        if (isLegal(board.moveBuffer[i], masks))
+            board.moveBuffer[index++] = board.moveBuffer[i];
+    }
+
+    return index;
+}
+
+
+
+// legalMoveCount
+//
+// Number of legal moves in the position, e.g. to tell checkmate and stalemate
+// apart from other positions. moveBuffer[] is used from index onwards.
+int legalMoveCount(int index)
+{
+    return legalgen(index) - index;
+}
+
+
+
+// evasiongen
+//
+// Check evasion generator, for positions where the side to move is in check:
+// only the king moves, the captures of the checking piece and the moves that
+// block its line to the king are generated (just the king moves in double
+// check). Pinned pieces are skipped, since they can never stop a check. The
+// masks of the position must be set (see setLegalMasks), and all the moves
+// returned are legal.
+//
+// The first free location in moveBuffer[] is supplied in index, and the new
+// first free location is returned.
+int evasiongen(int index, LegalMasks &masks)
+{
+    unsigned char piece, colour, pawn, opponentPawn;
+    unsigned int from, to, epPawn;
+    Bitboard tempPiece, tempMove, targetBitmap, freeSquares;
+    Bitboard ownPieces, ownPawns, opponentPieces;
+    Bitboard *pawnMoves, *pawnDoubleMoves, *pawnAttacks;
+    int promoRank, doubleRank;
+    Move move;
+
+    move.clear();
+    freeSquares = ~board.occupiedSquares;
+
+    if (board.nextMove)
+    {
+        ownPieces       = board.blackPieces;
+        ownPawns        = board.blackPawns;
+        opponentPieces  = board.whitePieces;
+        colour          = BLACK_PAWN & ~WHITE_PAWN;
+        pawn            = BLACK_PAWN;
+        opponentPawn    = WHITE_PAWN;
+        pawnMoves       = BLACK_PAWN_MOVES;
+        pawnDoubleMoves = BLACK_PAWN_DOUBLE_MOVES;
+        pawnAttacks     = BLACK_PAWN_ATTACKS;
+        promoRank       = 1;
+        doubleRank      = 7;
+        epPawn          = board.epSquare + 8;
+    }
+    else
+    {
+        ownPieces       = board.whitePieces;
+        ownPawns        = board.whitePawns;
+        opponentPieces  = board.blackPieces;
+        colour          = 0;
+        pawn            = WHITE_PAWN;
+        opponentPawn    = BLACK_PAWN;
+        pawnMoves       = WHITE_PAWN_MOVES;
+        pawnDoubleMoves = WHITE_PAWN_DOUBLE_MOVES;
+        pawnAttacks     = WHITE_PAWN_ATTACKS;
+        promoRank       = 8;
+        doubleRank      = 2;
+        epPawn          = board.epSquare - 8;
+    }
+
+    // King: step to any square that is not attacked once it has moved (no
+    // castling out of check)
+    from = masks.king;
+    move.setFrom(from);
+    move.setPiece(board.square[from]);
+    tempMove = KING_ATTACKS[from] & ~ownPieces;
+    board.occupiedSquares ^= BITSET[from];
+    while (tempMove)
+    {
+        to = firstOne(tempMove);
+        if (!isAttacked(BITSET[to], !board.nextMove))
+        {
+            move.setTosq(to);
+            move.setCapture(board.square[to]);
+            board.moveBuffer[index++].moveInt = move.moveInt;
+        }
+        tempMove ^= BITSET[to];
+    }
+    board.occupiedSquares ^= BITSET[from];
+
+    // in double check, only the king can move
+    if (masks.checkers & (masks.checkers - 1))
+        return index;
+
+    // the other pieces can only capture the checker or step in between
+    targetBitmap = masks.evasions & ~ownPieces;
+
+    // Pawns
+    move.setPiece(pawn);
+    tempPiece = ownPawns & ~masks.pinned;
+    while (tempPiece)
+    {
+        from = firstOne(tempPiece);
+        move.setFrom(from);
+        tempMove = pawnMoves[from] & freeSquares;
+        if ((RANKS[from] == doubleRank) && tempMove)
+            tempMove |= pawnDoubleMoves[from] & freeSquares;
+        tempMove |= pawnAttacks[from] & opponentPieces;
+        tempMove &= targetBitmap;
+        while (tempMove)
+        {
+            to = firstOne(tempMove);
+            move.setTosq(to);
+            move.setCapture(board.square[to]);
+            if (RANKS[to] == promoRank)
+            {
+                move.setPromo(colour | WHITE_QUEEN);  board.moveBuffer[index++].moveInt = move.moveInt;
+                move.setPromo(colour | WHITE_ROOK);   board.moveBuffer[index++].moveInt = move.moveInt;
+                move.setPromo(colour | WHITE_BISHOP); board.moveBuffer[index++].moveInt = move.moveInt;
+                move.setPromo(colour | WHITE_KNIGHT); board.moveBuffer[index++].moveInt = move.moveInt;
+                move.setPromo(EMPTY);
+            }
+            else
+            {
+                board.moveBuffer[index++].moveInt = move.moveInt;
+            }
+            tempMove ^= BITSET[to];
+        }
+
+        // en-passant capture of a checking pawn (it can uncover an attack on
+        // the rank of both pawns, so it goes through isLegal)
+        if (board.epSquare && (pawnAttacks[from] & BITSET[board.epSquare]) &&
+            (masks.checkers & BITSET[epPawn]) && (board.square[epPawn] == opponentPawn))
+        {
+            move.setPromo(pawn);
+            move.setCapture(opponentPawn);
+            move.setTosq(board.epSquare);
+            if (isLegal(move, masks))
+                board.moveBuffer[index++].moveInt = move.moveInt;
+            move.setPromo(EMPTY);
+        }
+        tempPiece ^= BITSET[from];
+    }
+
+    // Knights, bishops, rooks and queens
+    tempPiece = ownPieces & ~ownPawns & ~masks.pinned & ~BITSET[masks.king];
+    while (tempPiece)
+    {
+        from  = firstOne(tempPiece);
+        piece = board.square[from];
+        move.setFrom(from);
+        move.setPiece(piece);
+        if ((piece & 7) == WHITE_KNIGHT)
+            tempMove = KNIGHT_ATTACKS[from] & targetBitmap;
+        else if ((piece & 7) == WHITE_BISHOP)
+            tempMove = BISHOPMOVES(from);
+        else if ((piece & 7) == WHITE_ROOK)
+            tempMove = ROOKMOVES(from);
+        else
+            tempMove = QUEENMOVES(from);
+        while (tempMove)
+        {
+            to = firstOne(tempMove);
+            move.setTosq(to);
+            move.setCapture(board.square[to]);
+            board.moveBuffer[index++].moveInt = move.moveInt;
+            tempMove ^= BITSET[to];
+        }
+        tempPiece ^= BITSET[from];
+    }
+
+    return index;
+}
+
+
+
 // addCaptScore
 //
 // Use the static evaluator to find "better" moves by assigning them a score.
-void Board::addCaptScore(int &ifirst, int &index)
+void Board::addCaptScore(int &ifirst, int &index, int minScore)
 {
     int i, val;
     Move capt;
@@ -891,7 +1298,7 @@ void Board::addCaptScore(int &ifirst, int &index)
     val = SEE(moveBuffer[index]);
 
     // Discard this move if the score is not high enough:
-    if (val < MINCAPTVAL)
+    if (val < minScore)
     {
         index--;
         return;
@@ -39,6 +39,8 @@
 //
 // perft is also used to measure the performance of the move generator and (un)makeMove in terms
 // of speed, and to compare different implementations of generating, storing and (un)making moves.
+//
+// Since only legal moves are generated, the moves at the last ply are counted without making them.
 uint64_t perft(int ply, int depth)
 {
     uint64_t retVal = 0;     
@@ -51,15 +53,16 @@ uint64_t perft(int ply, int depth)
 
 
     // generate moves from this position
-    board.moveBufLen[ply+1] = movegen(board.moveBufLen[ply]);
+    board.moveBufLen[ply+1] = legalgen(board.moveBufLen[ply]);
+    if (depth == 1)
+        return board.moveBufLen[ply+1] - board.moveBufLen[ply];
 
 
     // loop over moves
     for (i = board.moveBufLen[ply]; i < board.moveBufLen[ply+1]; i++)
     {
         makeMove(board.moveBuffer[i]);
-        if (!isOtherKingAttacked())
-            retVal += perft(ply + 1, depth-1);
+        retVal += perft(ply + 1, depth-1);
         unmakeMove(board.moveBuffer[i]);
     }
 
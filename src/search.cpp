@@ -41,10 +41,14 @@
 #include <memory.h>
 #include <iomanip>
 #include <cinttypes>
+#include <algorithm>
+#include <thread>
+#include <vector>
 #include "definitions.h" 
 #include "extglobals.h" 
 #include "functions.h" 
-#include "board.h" 
+#include "board.h"
+#include "movepicker.h" 
 #include "timer.h" 
 #include "app.h"
 #include "cache.h"
@@ -56,21 +60,223 @@ using namespace std;
 
 
 // initialize basic variables for the iterative-deepening search
-unsigned short nextDepth = 0;
-ttEntry tt;
-float cacheHit;
+thread_local float cacheHit;
 int score = 0;
 
 
+// Lazy SMP: helper threads search the same root position as the main thread,
+// each on its own board, and only share the transposition table with it.
+// rootBoard is the position they start from, stopHelpers tells them that the
+// main thread is done and helperNodes counts the nodes they searched.
+static Board rootBoard;
+atomic<bool> stopHelpers(false);
+atomic<uint64_t> helperNodes(0);
+
+
+
+// helperSearch
+//
+// Entry point of a helper thread. The helper runs iterative deepening on a copy
+// of the root position until it reaches the search depth or the main thread is
+// done. Odd helpers start one ply deeper, so that not all threads search the
+// same depth at the same time. Results only reach the main thread through the
+// transposition table.
+static void helperSearch(int id)
+{
+    int depth;
+
+
+    board = rootBoard;
+    board.threadId = id;
+    board.nodes = 0;
+
+    for (depth = 1 + (id & 1); (depth <= board.searchDepth) && !stopHelpers; depth++)
+    {
+        board.moveBufLen[0] = 0;
+        board.followPV = true;
+        board.allownull = true;
+
+        board.alphabetapvs(0, depth, -LARGE_NUMBER, LARGE_NUMBER);
+        if (board.timedout)
+            break;
+
+        board.rememberPV();
+        helperNodes += board.nodes;
+        board.nodes = 0;
+    }
+
+    helperNodes += board.nodes;
+}
+
+
+
+// SearchHelpers
+//
+// Start searchThreads - 1 helper threads on the current position, and stop them
+// when the object goes out of scope, so that think() waits for them whichever
+// way it returns.
+class SearchHelpers
+{
+    private:
+        vector<thread> workers;
+
+    public:
+        SearchHelpers()
+        {
+            rootBoard = board;
+            stopHelpers = false;
+            helperNodes = 0;
+
+            for (int id = 1; id < searchThreads; id++)
+                workers.emplace_back(helperSearch, id);
+        }
+
+        ~SearchHelpers()
+        {
+            stopHelpers = true;
+
+            for (thread &w : workers)
+                w.join();
+        }
+};
+
+
+
+// updatePV
+//
+// Make the move, followed by the PV of the next ply, the PV of this ply.
+static void updatePV(int ply, Move &move)
+{
+    SearchStack *s = &board.ss[ply];
+    int length = min(s[1].pvLength, MAX_PLY - 1);
+
+    s[0].pv[0] = move;
+    memcpy(&s[0].pv[1], s[1].pv, length * sizeof(Move));
+    s[0].pvLength = length + 1;
+}
+
+
+
+// extendPV
+//
+// Complete the PV of the root with the moves stored in the cache for the
+// positions along it, for as long as they are legal and the line does not
+// repeat itself. MTD(f) only gets the first move of the PV from the search.
+static void extendPV()
+{
+    SearchStack &root = board.ss[0];
+    LegalMasks masks;
+    ttEntry tt;
+    Move move;
+    int i;
+
+
+    if (!useCache || !root.pvLength)
+        return;
+
+    for (i = 0; i < root.pvLength; i++)
+        makeMove(root.pv[i]);
+
+    while ((root.pvLength < MAX_PLY) && (board.repetitionCount() < 2))
+    {
+        tt = cache.peek(board.hashkey);
+        if ((tt.key != board.hashkey) || !tt.move)
+            break;
+
+        move.moveInt = tt.move;
+        setLegalMasks(masks);
+        if (!isPseudoLegal(move) || !isLegal(move, masks))
+            break;
+
+        root.pv[root.pvLength++] = move;
+        makeMove(move);
+    }
+
+    for (i = root.pvLength - 1; i >= 0; i--)
+        unmakeMove(root.pv[i]);
+}
+
+
+
+// Board::mtdf
+//
+// MTD(f) driver: find the score of the root at the given depth with a series
+// of null-window searches, each one proving the score to be either above or
+// below a test value, until the lower and upper bounds meet. The first test is
+// the guess (the score of the previous depth), and the cache keeps the nodes
+// of the earlier passes from being searched again.
+//
+// Since alphabetapvs fails hard, a pass only moves a bound up to the test
+// value: the test is moved away from the guess by a step that doubles after
+// each pass, and once both bounds are known they are bisected.
+int Board::mtdf(int depth, int guess)
+{
+    int lower, upper, test, value, step, pvLength;
+    Move pv[MAX_PLY];
+
+
+    lower    = -LARGE_NUMBER;
+    upper    =  LARGE_NUMBER;
+    test     = guess;
+    step     = MTDF_STEP;
+    pvLength = 0;
+
+    while (lower < upper)
+    {
+        followPV = true;
+        allownull = true;
+        stats.mtdfSearches++;
+
+        value = alphabetapvs(0, depth, test - 1, test);
+        if (timedout)
+            break;
+
+        // fail high: the root move that proved it is the best one so far
+        if (value >= test)
+        {
+            lower = test;
+            pvLength = ss[0].pvLength;
+            memcpy(pv, ss[0].pv, pvLength * sizeof(Move));
+        }
+        else
+            upper = test - 1;
+
+        // next test value
+        if (lower == -LARGE_NUMBER)
+            test = max(upper - step, -LARGE_NUMBER + 1);
+        else if (upper == LARGE_NUMBER)
+            test = min(lower + step, LARGE_NUMBER);
+        else
+            test = (lower + upper + 1) / 2;
+        step *= 2;
+    }
+
+    // leave the PV of the last pass that failed high where think() expects it,
+    // with the rest of the line taken from the cache
+    memcpy(ss[0].pv, pv, pvLength * sizeof(Move));
+    ss[0].pvLength = pvLength;
+    if (!timedout)
+        extendPV();
+
+    return lower;
+}
+
+
 
 // Board::think
 //
 // This is the iterative deepening framework to use alphabeta search. It starts
 // with depth=1 and searches the best move. After that, moves are sorted and
 // the best move is then searched at depth=2, then depth=3, etc.
+//
+// Every depth after the first is searched with an aspiration window of
+// SEARCH_WINDOW_SIZE around the score of the previous depth. If the score falls
+// outside of the window, the failing side is widened (twice as much each time)
+// and the depth is searched again. Alternatively, each depth can be searched
+// with MTD(f) (see mtdf).
 Move Board::think()
 {
-    int legalmoves, currentdepth;
+    int legalmoves, currentdepth, alpha, beta, delta;
     Move singlemove;
     cacheHit = 0;
 
@@ -86,13 +292,17 @@ Move Board::think()
 
 
     // initialize search with PV
+    rootMoves = legalmoves;
     lastPVLength = 0;
     memset(lastPV, 0 , sizeof(lastPV));
     memset(whiteHeuristics, 0, sizeof(whiteHeuristics));
     memset(blackHeuristics, 0, sizeof(blackHeuristics));
+    memset(ss, 0, sizeof(ss));
     nodes = 0;
     countdown = UPDATEINTERVAL;
     timedout = false;
+    memset(&stats, 0, sizeof(stats));
+    cache.newSearch();
 
 
     // display console header
@@ -105,20 +315,65 @@ Move Board::think()
     msStart = timer.getms();
 
 
+    // start the helper threads, if any
+    threadId = 0;
+    SearchHelpers helpers;
+
+
     //  iterative deepening:
     for (currentdepth = 1; currentdepth <= board.searchDepth; currentdepth++)
     {
-        // clear the buffers
-        memset(moveBufLen, 0, sizeof(moveBufLen));
-        memset(moveBuffer, 0, sizeof(moveBuffer));
-        memset(triangularLength, 0, sizeof(triangularLength));
-        memset(triangularArray, 0, sizeof(triangularArray));
+        // the moves of the root go first in the buffer (every node sets up the
+        // moves and the PV of its own ply, so nothing else needs clearing)
+        moveBufLen[0] = 0;
         followPV = true;
         allownull = true;
 
 
-        // enter actual search
-        score = alphabetapvs(0, currentdepth, -LARGE_NUMBER, LARGE_NUMBER);
+        // search with MTD(f), starting from the score of the previous depth
+        // (it needs the cache to avoid searching the tree all over again)
+        if (MTDF && useCache)
+            score = mtdf(currentdepth, score);
+        else
+        {
+            // otherwise, set the aspiration window
+            alpha = -LARGE_NUMBER;
+            beta  =  LARGE_NUMBER;
+            delta = SEARCH_WINDOW_SIZE;
+            if (currentdepth > 1)
+            {
+                alpha = max(score - delta, -LARGE_NUMBER);
+                beta  = min(score + delta,  LARGE_NUMBER);
+                stats.aspirationSearches++;
+            }
+
+
+            // enter actual search, widening the window until the score fits in it
+            while (true)
+            {
+                score = alphabetapvs(0, currentdepth, alpha, beta);
+
+                if (timedout)
+                    break;
+
+                if ((score <= alpha) && (alpha > -LARGE_NUMBER))
+                {
+                    alpha = max(alpha - delta, -LARGE_NUMBER);
+                    stats.failLow++;
+                }
+                else if ((score >= beta) && (beta < LARGE_NUMBER))
+                {
+                    beta = min(beta + delta, LARGE_NUMBER);
+                    stats.failHigh++;
+                }
+                else
+                    break;
+
+                delta *= 2;
+                followPV = true;
+                allownull = true;
+            }
+        }
 
 
         // check if time is up or if UCI asked to stop the search
@@ -145,7 +400,9 @@ Move Board::think()
         // display search analysis
         if (UCI)
         {
-            cout << "info score cp " << score << " depth " << currentdepth << " nodes " << nodes << " time " << timer.getms();
+            cout << "info score cp " << score << " depth " << currentdepth << " nodes " << (nodes + helperNodes) << " time " << timer.getms();
+            if (useCache)
+                cout << " hashfull " << cache.hashfull();
             cout << " pv ";
             displayUCIPV();
         }
@@ -168,26 +425,97 @@ Move Board::think()
 
 
 
+// scoreToTT
+//
+// Mate scores depend on the distance to the root, so they are converted to the
+// distance from the current node before being stored in the cache.
+static inline int scoreToTT(int score, int ply)
+{
+    if (score > (CHECKMATESCORE - 2*MAX_PLY))
+        return score + ply;
+    if (score < -(CHECKMATESCORE - 2*MAX_PLY))
+        return score - ply;
+    return score;
+}
+
+
+
+// scoreFromTT
+//
+// Convert a mate score stored in the cache back to the distance from the root.
+static inline int scoreFromTT(int score, int ply)
+{
+    if (score > (CHECKMATESCORE - 2*MAX_PLY))
+        return score - ply;
+    if (score < -(CHECKMATESCORE - 2*MAX_PLY))
+        return score + ply;
+    return score;
+}
+
+
+
+// staticEval
+//
+// Static evaluation of the board, looked up in the eval cache first.
+static int staticEval()
+{
+    int val;
+
+    if (!useCache || !evalCache.find(board.hashkey, val))
+    {
+        val = board.eval();
+        if (useCache)
+            evalCache.add(board.hashkey, val);
+    }
+
+    return val;
+}
+
+
+
+// repeats
+//
+// Tell whether the position with the given key, reached with the next move,
+// already appeared since the last irreversible move.
+static bool repeats(uint64_t key)
+{
+    for (int i = board.endOfSearch - 1; (i >= board.endOfSearch - board.fiftyMove) && (i >= 0); i -= 2)
+    {
+        if (board.gameLine[i].key == key)
+            return true;
+    }
+
+    return false;
+}
+
+
+
 // alphabetapvs
 //
 // Main alphabeta algorithm (Negamax) which relies on a Principal Variation
 // search. This algorithm uses the following steps:
 //
-//  1. null move pruning
-//  2. sort moves (score based on historic appearance, capture gain, etc)
-//  3. look up move hash (from previous searches)
-//  4. late move reductions (LMR)
-//  8. start full search
+//  0. look up the position in the cache (transposition table)
+//  1. razoring, null move pruning, ProbCut and internal iterative deepening
+//  2. pick moves in stages (hash move, captures, killers, history, etc), and
+//     look up the position after each one in the cache
+//  3. futility pruning and late move reductions (LMR)
+//  4. start full search
+//  5. store the result in the cache
 //
 // The score returned by the algorithm is always from calling qsearch().
 int Board::alphabetapvs(int ply, int depth, int alpha, int beta)
 {
-	int i, j, movesfound, pvmovesfound, val;
-    bool cached = false;
+	int i, movesfound, pvmovesfound, val, reduction, rbeta;
+    bool inCheck, prunable, futile, givesCheck, quiet, etc;
+    Move hashmove, iidmove;
+    LegalMasks masks;
+    ttEntry tt, child;
+    uint64_t key;
 
 
     // prepare structure to store the principal variation (PV)
-	triangularLength[ply] = ply;
+	ss[ply].pvLength = 0;
 
 
     // if at leaf node, return qiescent value
@@ -213,215 +541,462 @@ int Board::alphabetapvs(int ply, int depth, int alpha, int beta)
 
 
 
-	
-    // 1. Null move pruning
+    // 0. Transposition table lookup
+    //
+    // The stored move is always used to sort the moves. The stored score is
+    // only used for a cutoff if it was searched deep enough and its bound
+    // allows it. Cutoffs are not taken at PV nodes, to keep the PV intact.
+    hashmove.moveInt = 0;
+    if (useCache)
+    {
+        tt = cache.find(hashkey);
+        if (tt.key == hashkey)
+        {
+            hashmove.moveInt = tt.move;
+
+            if (ply && (beta - alpha == 1) && (tt.depth >= depth))
+            {
+                val = scoreFromTT(tt.score, ply);
+
+                if ((tt.bound == TT_BOUND_EXACT) ||
+                    ((tt.bound == TT_BOUND_LOWER) && (val >= beta)) ||
+                    ((tt.bound == TT_BOUND_UPPER) && (val <= alpha)))
+                {
+                    cacheHit++;
+                    cache.cutoff();
+
+                    if (val >= beta)
+                        return beta;
+                    if (val <= alpha)
+                        return alpha;
+                    return val;
+                }
+            }
+        }
+    }
+
+
+    // look the children of deep non-PV nodes up in the cache before searching
+    // them (enhanced transposition cutoffs, see below)
+    etc = useCache && ply && (beta - alpha == 1) && (depth >= ETC_DEPTH) &&
+          (abs(beta) < CHECKMATESCORE - MAX_PLY);
+    if (etc)
+        stats.etcNodes++;
+
+
+
+    // 1. Razoring
+    //
+    // At frontier nodes, if the static evaluation is far below alpha, a quiet
+    // move is unlikely to bring the score back: verify it with the quiescent
+    // search and return if it fails low. Not done if the side on move is in
+    // check, at PV nodes or when the bounds are mate scores.
+    inCheck  = isOwnKingAttacked();
+    ss[ply].staticEval = inCheck ? -LARGE_NUMBER : staticEval();
+    prunable = !inCheck && !followPV && (beta - alpha == 1) &&
+               (abs(alpha) < CHECKMATESCORE - MAX_PLY) && (abs(beta) < CHECKMATESCORE - MAX_PLY);
+    futile   = false;
+    if (FUTILITY && prunable && (depth <= RAZOR_DEPTH))
+    {
+        val = ss[ply].staticEval;
+
+        // quiet moves at this node cannot raise the score above alpha either
+        // (see futility pruning below)
+        futile = (depth <= FUTILITY_DEPTH) && (val + FUTILITY_MARGIN * depth <= alpha);
+
+        if (val + RAZOR_MARGIN * depth <= alpha)
+        {
+            stats.razored++;
+
+            val = qsearch(ply, alpha, beta);
+            if (timedout)
+                return 0;
+            if (val <= alpha)
+                return alpha;
+        }
+    }
+
+
+    // Null move pruning
     // 
     // Not allowed if:
     //  - side on move is in check (illegal position)
     //  - coming from another null move (burn 2 plies uselessly)
     //  - side on move has only pawns left (avoid zugzwang regressions)
-	if (!followPV && allownull)
+    //  - the static evaluation is below beta (the null move would fail low)
+    //
+    // The reduction grows with the depth and with the margin of the static
+    // evaluation over beta. At high depths, a fail high is only trusted if a
+    // reduced search without null move agrees (zugzwang verification).
+	if (!followPV && allownull && !inCheck && (beta - alpha == 1) &&
+        (!ply || ss[ply-1].move.moveInt) && (abs(beta) < CHECKMATESCORE - MAX_PLY))
 	{
 		if ((nextMove && (board.totalBlackPieces > NULLMOVE_LIMIT)) || (!nextMove && (board.totalWhitePieces > NULLMOVE_LIMIT)))
 		{
-			if (!isOwnKingAttacked())
+            val = ss[ply].staticEval;
+			if (val >= beta)
 			{
-                // don't allow two consecutive null moves
-				allownull = false;
+                reduction = NULLMOVE_REDUCTION + depth / NULLMOVE_DEPTH_DIVISOR +
+                            min((val - beta) / NULLMOVE_EVAL_DIVISOR, NULLMOVE_EVAL_MAX);
 
                 // check the clock and the input status
 				if (--countdown <=0)
                     readClockAndInput();
 
-				nextMove = !nextMove;
-				hashkey ^= KEY.side; 
-				val = -alphabetapvs(ply, depth - NULLMOVE_REDUCTION, -beta, -beta+1);
-				nextMove = !nextMove;
-				hashkey ^= KEY.side;
+                // the reply generates its moves where this node would, and
+                // sees that it comes from a null move
+                stats.nullMoves++;
+                moveBufLen[ply+1] = moveBufLen[ply];
+                ss[ply].move.moveInt = 0;
+                makeNullMove();
+				val = -alphabetapvs(ply+1, depth - reduction, -beta, -beta+1);
+                unmakeNullMove();
 
                 // if time's up, stop searching
 				if (timedout)
                     return 0;
 
+                // verify the fail high without a null move at this node (the
+                // null move search allowed it again at the nodes below)
+                if ((val >= beta) && (depth >= NULLMOVE_VERIFY_DEPTH))
+                {
+                    stats.nullVerified++;
+                    allownull = false;
+                    val = alphabetapvs(ply, depth - reduction, beta - 1, beta);
+                    if (timedout)
+                        return 0;
+                    if (val < beta)
+                        stats.nullRefuted++;
+                }
+
                 // end of null move pruning
 				allownull = true;
 
                 // if fail high, return beta bound
 				if (val >= beta)
+                {
+                    stats.nullCutoffs++;
                     return beta;
+                }
+
+                ss[ply].pvLength = 0;
 			}
 		}
 	}
 
 
+    // ProbCut
+    //
+    // At non-PV nodes deep enough, if a capture that wins material is still
+    // above beta by PROBCUT_MARGIN after a reduced search, a full depth search
+    // would most likely fail high too. Only the captures that can get there
+    // according to SEE are tried, and each one is first checked with qsearch.
+    if (!followPV && !inCheck && (beta - alpha == 1) && (depth >= PROBCUT_DEPTH) &&
+        (abs(beta) < CHECKMATESCORE - MAX_PLY - PROBCUT_MARGIN))
+    {
+        rbeta = beta + PROBCUT_MARGIN;
+        moveBufLen[ply+1] = captgen(moveBufLen[ply], max(rbeta - ss[ply].staticEval, 0));
+        if (moveBufLen[ply+1] > moveBufLen[ply])
+        {
+            stats.probCutNodes++;
+            setLegalMasks(masks);
+        }
+
+        for (i = moveBufLen[ply]; i < moveBufLen[ply+1]; i++)
+        {
+            if (!isLegal(moveBuffer[i], masks))
+                continue;
+
+            stats.probCutMoves++;
+            ss[ply].move = moveBuffer[i];
+            makeMove(moveBuffer[i]);
+            val = -qsearch(ply+1, -rbeta, -rbeta+1);
+            if (val >= rbeta)
+                val = -alphabetapvs(ply+1, depth - PROBCUT_REDUCTION, -rbeta, -rbeta+1);
+            unmakeMove(moveBuffer[i]);
+
+            if (timedout)
+                return 0;
+
+            if (val >= rbeta)
+            {
+                stats.probCutoffs++;
+                return beta;
+            }
+        }
+
+        ss[ply].pvLength = 0;
+    }
+
+
+    // Internal iterative deepening (IID)
+    //
+    // At a PV node without a hash move (nor a move from the previous PV), the
+    // moves would be sorted by their history only: search the node at a
+    // reduced depth first, and try the best move found there first.
+    iidmove.moveInt = 0;
+    if (!hashmove.moveInt && (beta - alpha > 1) && (depth >= IID_DEPTH) && !followPV)
+    {
+        stats.iidSearches++;
+
+        alphabetapvs(ply, depth - IID_REDUCTION, alpha, beta);
+        if (timedout)
+            return 0;
+
+        // the move is in the PV if the search raised alpha, otherwise it can
+        // only be in the cache (fail high)
+        if (ss[ply].pvLength)
+            iidmove = ss[ply].pv[0];
+        else if (useCache)
+        {
+            tt = cache.find(hashkey);
+            if (tt.key == hashkey)
+                iidmove.moveInt = tt.move;
+        }
+
+        hashmove = iidmove;
+        ss[ply].pvLength = 0;
+    }
+
+
     // prepare to start a full-depth search
 	allownull       = true;
 	movesfound      = 0;
 	pvmovesfound    = 0;
-    unsigned moveNo = 0;
-
+    int moveNo      = 0;
 
-    // generate a list of moves, sorted by three main criteria:
-    //  1. first  -> static exchange evaluatoin (SEE)
-    //  2. second -> high-gain captures first (MVV/LVA)
-    //  3. third  -> historically "good" moves (those which produce cut-off) 
-    //  4. rest of the moves
-	moveBufLen[ply+1] = movegen(moveBufLen[ply]);
 
+    // pick the moves in stages (see movepicker.h), generating them only when
+    // they are needed:
+    //  1. first  -> the move from the previous PV, and the hash move
+    //  2. second -> captures and promotions that do not lose material (SEE)
+    //  3. third  -> killer moves (quiet moves that produced a cut-off at this ply)
+    //  4. rest of the moves, historically "good" moves first
+    //  5. last   -> captures that lose material
+    MovePicker picker(ply, (followPV && (depth > 1)) ? lastPV[ply] : NOMOVE, hashmove);
 
 
     // go through every move and search the tree below
-	for (i = moveBufLen[ply]; i < moveBufLen[ply+1]; i++)
+	while ((i = picker.next()) >= 0)
 	{
-        // pick the next best move from a sorted list
-		selectmove(ply, i, depth, followPV); 
+        // Enhanced transposition cutoffs (ETC)
+        //
+        // If the position after the move was searched deep enough and its
+        // score (an upper bound for the opponent) refutes this node, there is
+        // no need to search it again. Only the moves handed out by the picker
+        // are looked up, so nothing is generated for it. Positions that repeat
+        // an earlier one are skipped: their stored score ignores the draw.
+        key = keyAfterMove(moveBuffer[i]);
+        if (etc)
+        {
+            child = cache.peek(key);
+            if ((child.key == key) && (child.depth >= depth - 1) && (child.bound != TT_BOUND_LOWER) &&
+                (-scoreFromTT(child.score, ply+1) >= beta) && !repeats(key))
+            {
+                stats.etcCutoffs++;
 
+                tt.key   = hashkey;
+                tt.move  = moveBuffer[i].moveInt;
+                tt.score = scoreToTT(beta, ply);
+                tt.depth = depth;
+                tt.bound = TT_BOUND_LOWER;
+                cache.add(hashkey, &tt);
 
-        // make th emove and evaluate the board
-		makeMove(moveBuffer[i]);
-		{
-            // try to find the current position in the cache
-            cached = false;
-            if (useCache)
-            {
-                tt = cache.find(board.hashkey, depth);
-                if ((tt.key != 0) && (tt.depth != TT_EMPTY_VALUE))
-                {
-                    cacheHit++;
-                    val = tt.score;
-                    cached = true;
-
-                    // XXX TT XXX
-					triangularArray[ply][ply] = moveBuffer[i];
-                    //lastPV[i] = board.triangularArray[0][i];
-                    //lastPVLength = board.triangularLength[0];
-                    rememberPV();
-                }
+                return beta;
             }
+        }
 
-            // only search this move if legal --> remember that movegen() returns
-            // pseudo-legal moves
-			if (!isOtherKingAttacked()) 
-			{
-                moveNo++;
+        // otherwise, start loading the child's cache bucket, so that it is
+        // (hopefully) in the CPU cache by the time the child probes it
+        else if (useCache && (depth > 1))
+            cache.prefetch(key);
 
-                // check the clock and the input status
-				if (--countdown <=0)
-                    readClockAndInput();
 
-				movesfound++;
+        // make th emove and evaluate the board (the picker only returns legal
+        // moves)
+        ss[ply].move = moveBuffer[i];
+		makeMove(moveBuffer[i]);
+        moveNo++;
 
+        // check the clock and the input status
+		if (--countdown <=0)
+            readClockAndInput();
 
-				if (!ply && (depth > 1))
-                    if (!beQuiet)
-                        displaySearchStats(3, ply, i); 
+		movesfound++;
 
 
-                // Alphabeta with Principal Variation Search (PVS)
-                if (!cached)
-                {
-                    // LMR
-                    //
-                    // Configure late-move reductions (LMR): assuming that the moves in the
-                    // list are ordered from potential best to potential worst, analyzing 
-                    // the first moves is more critical than the last ones. Therefore, 
-                    // using LMR we analyze the first 2 moves in full-depth, but cut down
-                    // the analysis depth for the rest of moves.
-                    nextDepth = depth - 1;
-                    if (LMR && (ply > LMR_PLY_START) && (depth > LMR_SEARCH_DEPTH)
-                                              && !((moveBuffer[i]).isCapture())
-                                              && !((moveBuffer[i]).isPromo())
-                                              && !(isOwnKingAttacked())
-                                              && !(isOtherKingAttacked())
-                                              && (moveNo > LMR_MOVE_START) && !pvmovesfound)
-                    {
-                        nextDepth = depth - 2;
-                    }
-
-                    if (pvmovesfound)
-                    {
-                        val = -alphabetapvs(ply+1, depth-1, -alpha-1, -alpha); 
-
-                        // in case of failure, proceed with normal alphabeta
-                        if ((val > alpha) && (val < beta))
-                        {
-                            val = -alphabetapvs(ply+1, depth-1, -beta, -alpha);  		        
-                        }
-                    } 
-                    // normal alphabeta
-                    else
-                    {
-                        val = -alphabetapvs(ply+1, nextDepth, -beta, -alpha);
-                    }
-                }
-				unmakeMove(moveBuffer[i]);
+		if (!ply && (depth > 1))
+            if (!beQuiet && !threadId)
+                displaySearchStats(3, movesfound, i);
 
 
-                // if time is up, then return
-				if (timedout)
-                    return 0;
+        givesCheck = isOwnKingAttacked();
+        quiet      = !moveBuffer[i].isCapture() && !moveBuffer[i].isPromo() && !givesCheck;
 
 
-                // fail high (beta cutoff): return beta and update history heuristics
-				if (val >= beta)
-				{
-					if (nextMove) 
-						blackHeuristics[moveBuffer[i].getFrom()][moveBuffer[i].getTosq()] += depth*depth;
-					else 
-						whiteHeuristics[moveBuffer[i].getFrom()][moveBuffer[i].getTosq()] += depth*depth;
+        // Futility pruning
+        //
+        // Skip the quiet moves of a futile node (see razoring above),
+        // unless they give check. The first legal move is always
+        // searched, so that the node has a score to return.
+        if (futile && quiet && (movesfound > 1))
+        {
+            stats.futilityPruned++;
+            unmakeMove(moveBuffer[i]);
+            continue;
+        }
 
-					return beta;
-				}
 
+        // Late move pruning
+        //
+        // At the last plies, the quiet moves that come late in the
+        // list (after the hash move, captures, killers and the best
+        // history moves) hardly ever cut, so skip them altogether.
+        if (LMR && prunable && quiet && (depth <= LMP_DEPTH) &&
+            (moveNo > LMP_MOVE_START + depth * depth))
+        {
+            stats.lateMovePruned++;
+            unmakeMove(moveBuffer[i]);
+            continue;
+        }
 
-                // found a better move (PV candidate)
-				if (val > alpha)
-				{
-                    // update bounds
-					alpha = val;
-					pvmovesfound++;
 
+        // LMR
+        //
+        // Configure late-move reductions (LMR): assuming that the moves in the
+        // list are ordered from potential best to potential worst, analyzing 
+        // the first moves is more critical than the last ones. Therefore, 
+        // using LMR we analyze the first moves in full-depth, but cut down
+        // the analysis depth for the rest of quiet moves, the more the
+        // deeper the search and the later the move (see LMR_REDUCTIONS).
+        // Reduced moves are searched with a null window, and searched
+        // again at full depth if they fail high.
+        reduction = 0;
+        if (LMR && quiet && !inCheck && (depth >= LMR_SEARCH_DEPTH) && (moveNo > LMR_MOVE_START))
+        {
+            reduction = LMR_REDUCTIONS[min(depth, MAX_PLY - 1)][min(moveNo, LMR_MAX_MOVES - 1)];
 
-                    // save this move in Principal Variation
-					triangularArray[ply][ply] = moveBuffer[i];
+            // reduce less at PV nodes and for the killer moves
+            if ((beta - alpha > 1) || (moveBuffer[i].moveInt == ss[ply].killers[0].moveInt) ||
+                                      (moveBuffer[i].moveInt == ss[ply].killers[1].moveInt))
+                reduction--;
 
+            // always leave at least one ply to search
+            reduction = max(0, min(reduction, depth - 2));
+        }
 
-                    // append the latest best PV from deeper plies
-					for (j = ply + 1; j < triangularLength[ply+1]; j++) 
-						triangularArray[ply][j] = triangularArray[ply+1][j];
-					triangularLength[ply] = triangularLength[ply+1];
+        if (reduction)
+        {
+            stats.lmrReductions++;
+            val = -alphabetapvs(ply+1, depth-1-reduction, -alpha-1, -alpha);
 
+            if (val > alpha)
+                stats.lmrResearches++;
+        }
 
-                    // show intermediate search results
-					if (!ply && !beQuiet && (depth > 1))
-                        displaySearchStats(2, depth, val);
-				}
-			}
-			else unmakeMove(moveBuffer[i]);
-		}
 
-        
-        // Store in cache (replacement scheme --> always replace)
-        if (useCache && !cached)
+        // Alphabeta with Principal Variation Search (PVS), unless a
+        // reduced search already failed low
+        if (!reduction || (val > alpha))
         {
-            if ((val > -CHECKMATESCORE) && (val < CHECKMATESCORE))
+            if (pvmovesfound)
             {
-                tt.key   = board.hashkey;
-                tt.score = val;
-                tt.depth = depth;
-                cache.add(board.hashkey, &tt);
+                val = -alphabetapvs(ply+1, depth-1, -alpha-1, -alpha); 
+
+                // in case of failure, proceed with normal alphabeta
+                if ((val > alpha) && (val < beta))
+                {
+                    val = -alphabetapvs(ply+1, depth-1, -beta, -alpha);
+                }
+            } 
+            // normal alphabeta
+            else
+            {
+                val = -alphabetapvs(ply+1, depth-1, -beta, -alpha);
             }
         }
+		unmakeMove(moveBuffer[i]);
+
+
+        // if time is up, then return
+		if (timedout)
+            return 0;
+
+
+        // fail high (beta cutoff): return beta and update history heuristics
+		if (val >= beta)
+		{
+			if (nextMove) 
+				blackHeuristics[moveBuffer[i].getFrom()][moveBuffer[i].getTosq()] += depth*depth;
+			else 
+				whiteHeuristics[moveBuffer[i].getFrom()][moveBuffer[i].getTosq()] += depth*depth;
+
+            // remember quiet cutoff moves as killers of this ply
+            if (!moveBuffer[i].isCapture() && !moveBuffer[i].isPromo() &&
+                (moveBuffer[i].moveInt != ss[ply].killers[0].moveInt))
+            {
+                ss[ply].killers[1] = ss[ply].killers[0];
+                ss[ply].killers[0] = moveBuffer[i];
+            }
+
+            stats.betaCutoffs++;
+            if (movesfound == 1)
+                stats.firstMoveCutoffs++;
+
+            // at the root, the cutoff move is the best move of an MTD(f) pass
+            if (!ply)
+            {
+                ss[0].pv[0] = moveBuffer[i];
+                ss[0].pvLength = 1;
+            }
+            if (iidmove.moveInt && (moveBuffer[i].moveInt == iidmove.moveInt))
+                stats.iidBestMoves++;
+
+            // store the cutoff move with a lower bound
+            if (useCache)
+            {
+                tt.key   = hashkey;
+                tt.move  = moveBuffer[i].moveInt;
+                tt.score = scoreToTT(beta, ply);
+                tt.depth = depth;
+                tt.bound = TT_BOUND_LOWER;
+                cache.add(hashkey, &tt);
+            }
+
+			return beta;
+		}
+
+
+        // found a better move (PV candidate)
+		if (val > alpha)
+		{
+            // update bounds
+			alpha = val;
+			pvmovesfound++;
+
+
+            // save this move, followed by the PV of the next ply, as the
+            // Principal Variation of this ply
+			updatePV(ply, moveBuffer[i]);
+
+
+            // show intermediate search results
+			if (!ply && !beQuiet && !threadId && (depth > 1))
+                displaySearchStats(2, depth, val);
+		}
 	}
 
 
 	// update the history heuristic
 	if (pvmovesfound)
 	{
+        if (iidmove.moveInt && (ss[ply].pv[0].moveInt == iidmove.moveInt))
+            stats.iidBestMoves++;
+
 		if (nextMove) 
-			blackHeuristics[triangularArray[ply][ply].getFrom()][triangularArray[ply][ply].getTosq()] += depth*depth;
+			blackHeuristics[ss[ply].pv[0].getFrom()][ss[ply].pv[0].getTosq()] += depth*depth;
 		else
-			whiteHeuristics[triangularArray[ply][ply].getFrom()][triangularArray[ply][ply].getTosq()] += depth*depth;
+			whiteHeuristics[ss[ply].pv[0].getFrom()][ss[ply].pv[0].getTosq()] += depth*depth;
 	}
 
 
@@ -440,6 +1015,27 @@ int Board::alphabetapvs(int ply, int depth, int alpha, int beta)
 	}
 
 
+    // store the result in the cache: exact score if a PV move was found,
+    // otherwise an upper bound (all the moves failed low)
+    if (useCache)
+    {
+        tt.key   = hashkey;
+        tt.score = scoreToTT(alpha, ply);
+        tt.depth = depth;
+        if (pvmovesfound)
+        {
+            tt.move  = ss[ply].pv[0].moveInt;
+            tt.bound = TT_BOUND_EXACT;
+        }
+        else
+        {
+            // keep the move from the previous search of this position, if any
+            tt.bound = TT_BOUND_UPPER;
+        }
+        cache.add(hashkey, &tt);
+    }
+
+
     // return the best possible score that fails low
 	return alpha;
 }
@@ -471,6 +1067,7 @@ void Board::displaySearchStats(int mode, int depth, int score)
     // mode = 2 : display full stats, including score and latest PV
     // mode = 3 : display current root move that is being searched
     //            depth = ply, score = loop counter in the search move list 
+    // mode = 4 : display the counters of the last search
     switch (mode)
     {
         case 1: 
@@ -534,7 +1131,7 @@ void Board::displaySearchStats(int mode, int depth, int score)
                 break;
 
             mstostring(dt, timestring);
-            printf("             (%2d/%2d) %8s       ", score+1, moveBufLen[depth+1]-moveBufLen[depth], timestring);
+            printf("             (%2d/%2d) %8s       ", depth, rootMoves, timestring);
             unmakeMove(moveBuffer[score]);
             toSan(moveBuffer[score], sanMove);
             cout << sanMove;
@@ -544,6 +1141,37 @@ void Board::displaySearchStats(int mode, int depth, int score)
             break;
         }
 
+        case 4:
+        {
+            cout << "Nodes: " << nodes << endl;
+            cout << "Aspiration windows: " << stats.aspirationSearches << " searches, ";
+            cout << stats.failHigh << " fail-high and " << stats.failLow << " fail-low re-searches" << endl;
+            cout << "MTD(f): " << stats.mtdfSearches << " null-window searches" << endl;
+            cout << "Beta cutoffs: " << stats.betaCutoffs;
+            if (stats.betaCutoffs)
+                cout << " (" << fixed << setprecision(1) << (100.0 * stats.firstMoveCutoffs / stats.betaCutoffs) << "% by the first move)";
+            cout << endl;
+            cout << "Futility pruning: " << stats.futilityPruned << " moves, razoring: " << stats.razored << " nodes" << endl;
+            cout << "Quiescent search: " << stats.qnodes << " nodes";
+            if (nodes)
+                cout << " (" << fixed << setprecision(1) << (100.0 * stats.qnodes / nodes) << "% of all nodes)";
+            cout << ", " << stats.deltaPruned << " captures delta pruned" << endl;
+            cout << "Late moves: " << stats.lmrReductions << " reduced (" << stats.lmrResearches << " searched again), ";
+            cout << stats.lateMovePruned << " pruned" << endl;
+            cout << "Null moves: " << stats.nullMoves << " searched, " << stats.nullCutoffs << " cutoffs, ";
+            cout << stats.nullVerified << " verified (" << stats.nullRefuted << " refuted)" << endl;
+            cout << "ProbCut: " << stats.probCutoffs << " cutoffs in " << stats.probCutNodes << " nodes";
+            if (stats.probCutNodes)
+                cout << " (" << fixed << setprecision(1) << (100.0 * stats.probCutoffs / stats.probCutNodes) << "%)";
+            cout << ", " << stats.probCutMoves << " captures searched" << endl;
+            cout << "Enhanced transposition cutoffs: " << stats.etcCutoffs << " in " << stats.etcNodes << " nodes" << endl;
+            cout << "Internal iterative deepening: " << stats.iidSearches << " searches";
+            if (stats.iidSearches)
+                cout << " (" << fixed << setprecision(1) << (100.0 * stats.iidBestMoves / stats.iidSearches) << "% found the best move)";
+            cout << endl;
+            break;
+        }
+
         default: break;
     }
 }
@@ -556,8 +1184,8 @@ void Board::displaySearchStats(int mode, int depth, int score)
 // checkmate, stalemate, 75-move rule, or insufficient material.
 bool Board::isEndOfgame(int &legalmoves, Move &singlemove)
 {
-    int whiteknights, whitebishops, whiterooks, whitequeens, whitetotalmat;
-    int blackknights, blackbishops, blackrooks, blackqueens, blacktotalmat;
+    const materialEntry *mat;
+    materialEntry scratch;
 
     // are we checkmating the other side?
     if (isOtherKingAttacked()) 
@@ -577,19 +1205,11 @@ bool Board::isEndOfgame(int &legalmoves, Move &singlemove)
     }
 
     // how many legal moves do we have?
-    legalmoves = 0;
     moveBufLen[0] = 0;
-    moveBufLen[1] = movegen(moveBufLen[0]);
-    for (auto i = moveBufLen[0]; i < moveBufLen[1]; i++)
-    {
-        makeMove(moveBuffer[i]);
-        if (!isOtherKingAttacked())
-        { 
-            legalmoves++;
-            singlemove = moveBuffer[i];
-        }
-        unmakeMove(moveBuffer[i]);
-    }
+    moveBufLen[1] = legalgen(moveBufLen[0]);
+    legalmoves = moveBufLen[1] - moveBufLen[0];
+    if (legalmoves)
+        singlemove = moveBuffer[moveBufLen[0]];
 
     // checkmate or stalemate?
     if (!legalmoves) 
@@ -611,56 +1231,16 @@ bool Board::isEndOfgame(int &legalmoves, Move &singlemove)
         return true;
     }
 
-    // draw due to insufficient material:
-    if (!whitePawns && !blackPawns)
+    // draw due to insufficient material (K-K, KN-K, Kminor-Kminor or only
+    // bishops, all on the same color):
+    mat = probeMaterial(scratch);
+    if ((mat->gameDraw == MATERIAL_DRAW) ||
+        ((mat->gameDraw == MATERIAL_BISHOP_DRAW) &&
+         (!((whiteBishops | blackBishops) & WHITE_SQUARES) ||
+          !((whiteBishops | blackBishops) & BLACK_SQUARES))))
     {
-        whiteknights = bitCnt(whiteKnights);
-        whitebishops = bitCnt(whiteBishops);
-        whiterooks = bitCnt(whiteRooks);
-        whitequeens = bitCnt(whiteQueens);
-        whitetotalmat = 3 * whiteknights + 3 * whitebishops + 5 * whiterooks + 10 * whitequeens;
-        blackknights = bitCnt(blackKnights);
-        blackbishops = bitCnt(blackBishops);
-        blackrooks = bitCnt(blackRooks);
-        blackqueens = bitCnt(blackQueens);
-        blacktotalmat = 3 * blackknights + 3 * blackbishops + 5 * blackrooks + 10 * blackqueens;
-
-        // king versus king:
-        if ((whitetotalmat == 0) && (blacktotalmat == 0)) 
-        {
-            cout << "1/2-1/2 {material}" << endl;
-            return true;
-        }
-
-        // king and knight versus king:
-        if (((whitetotalmat == 3) && (whiteknights == 1) && (blacktotalmat == 0)) ||
-                ((blacktotalmat == 3) && (blackknights == 1) && (whitetotalmat == 0))) 
-        {
-            cout << "1/2-1/2 {material}" << endl;
-            return true;
-        }
-
-        // 2 kings with one or more bishops, all bishops on the same colour:
-        if ((whitebishops + blackbishops) > 0)
-        {
-            if ((whiteknights == 0) && (whiterooks == 0) && (whitequeens == 0) &&
-                    (blackknights == 0) && (blackrooks == 0) && (blackqueens == 0))
-            {
-                if (!((whiteBishops | blackBishops) & WHITE_SQUARES) ||
-                        !((whiteBishops | blackBishops) & BLACK_SQUARES))
-                {
-                    cout << "1/2-1/2 {material}" << endl;
-                    return true;
-                }
-            }
-        }
-
-        // 4.5 K(B||N)-K(B||N)
-        if ((whitetotalmat == 3) && (blacktotalmat == 3))
-        {
-            cout << "1/2-1/2 {material}" << endl;
-            return true;
-        }
+        cout << "1/2-1/2 {material}" << endl;
+        return true;
     }
 
     // draw due to repetition:
@@ -706,11 +1286,11 @@ int Board::repetitionCount()
 // they usually contain good moves to try.
 void Board::rememberPV()
 {
-    lastPVLength = board.triangularLength[0];
+    lastPVLength = ss[0].pvLength;
 
-    for (int i = 0; i < board.triangularLength[0]; i++)
+    for (int i = 0; i < ss[0].pvLength; i++)
     {
-        lastPV[i] = board.triangularArray[0][i];
+        lastPV[i] = ss[0].pv[i];
     }
 }
 
@@ -750,9 +1330,16 @@ void mstostring(uint64_t dt, char *timestring)
 // a) no more possible captures
 // b) no more checks possible
 // c) no more pawn promotions
+//
+// Only the captures that win material according to SEE are generated (see
+// captgen), and those that cannot bring the score up to alpha even if the
+// captured piece came for free are skipped (delta pruning). When in check,
+// there is no standing pat and every evasion is searched instead (see
+// evasiongen).
 int Board::qsearch(int ply, int alpha, int beta)
 {
-    int i, j, val;
+    int i, val, standPat, gain;
+    LegalMasks masks;
 
 
     // check the clock and the input status
@@ -767,35 +1354,33 @@ int Board::qsearch(int ply, int alpha, int beta)
 
     // increment nodes count
     nodes++;
+    stats.qnodes++;
 
 
-    // XXX
-    triangularLength[ply] = ply;
-
-
-    // in-check extension (search one more ply when in check)
-    if (isOwnKingAttacked())
-        return alphabetapvs(ply, 1, alpha, beta);
-
-   
-    // calculate standing pat as a baseline for the quiescent search
-    val = board.eval();
+    // prepare structure to store the principal variation (PV)
+    ss[ply].pvLength = 0;
 
-    if (val >= beta)
-        return beta;
 
-    if (val > alpha)
-        alpha = val;
+    // a long series of checks could overflow the PV and the move buffer
+    if (ply >= MAX_PLY - 1)
+        return staticEval();
 
 
-    // generate captures & promotions: captgen returns a sorted move list
-    moveBufLen[ply+1] = captgen(moveBufLen[ply]);
-    for (i = moveBufLen[ply]; i < moveBufLen[ply+1]; i++)
+    // in-check extension: try every evasion, or return the mate score if there
+    // is none (checks can repeat, unlike captures)
+    setLegalMasks(masks);
+    if (masks.checkers)
     {
-        makeMove(moveBuffer[i]);
+        if (repetitionCount() >= 3)
+            return DRAWSCORE;
 
-        if (!isOtherKingAttacked()) 
+        moveBufLen[ply+1] = evasiongen(moveBufLen[ply], masks);
+        if (moveBufLen[ply+1] == moveBufLen[ply])
+            return (-CHECKMATESCORE+ply-1);
+
+        for (i = moveBufLen[ply]; i < moveBufLen[ply+1]; i++)
         {
+            makeMove(moveBuffer[i]);
             val = -qsearch(ply+1, -beta, -alpha);
             unmakeMove(moveBuffer[i]);
 
@@ -805,81 +1390,61 @@ int Board::qsearch(int ply, int alpha, int beta)
             if (val > alpha)
             {
                 alpha = val;
-                triangularArray[ply][ply] = moveBuffer[i];
-                for (j = ply + 1; j < triangularLength[ply+1]; j++) 
-                    triangularArray[ply][j] = triangularArray[ply+1][j];
-                triangularLength[ply] = triangularLength[ply+1];
+                updatePV(ply, moveBuffer[i]);
             }
         }
-        else unmakeMove(moveBuffer[i]);
 
+        return alpha;
     }
 
-    return alpha;
-}
+   
+    // calculate standing pat as a baseline for the quiescent search
+    val = standPat = staticEval();
 
+    if (val >= beta)
+        return beta;
 
+    if (val > alpha)
+        alpha = val;
 
-// Board::selectmove()
-//
-// Re-order the move list so that the best move is selected as the next move to try.
-void Board::selectmove(int &ply, int &i, int &depth, bool &isFollowPV)
-{
-    int j, k;
-    unsigned int best;
-    Move temp;
 
-    if (isFollowPV && depth > 1)
+    // generate captures & promotions: captgen returns a sorted move list,
+    // without the captures that lose material
+    moveBufLen[ply+1] = captgen(moveBufLen[ply], MINCAPTVAL);
+
+    for (i = moveBufLen[ply]; i < moveBufLen[ply+1]; i++)
     {
-        for (j = i; j < moveBufLen[ply+1]; j++)
+        // delta pruning: skip the capture if winning the piece (and promoting)
+        // plus a safety margin still leaves the score below alpha
+        if (FUTILITY)
         {
-            if (moveBuffer[j].moveInt == lastPV[ply].moveInt)
+            gain = PIECEVALUES[moveBuffer[i].getCapture()];
+            if (moveBuffer[i].isPromo())
+                gain += PIECEVALUES[moveBuffer[i].getPromo()] - PAWN_VALUE;
+
+            if (standPat + gain + DELTA_MARGIN <= alpha)
             {
-                temp.moveInt = moveBuffer[j].moveInt;
-                moveBuffer[j].moveInt = moveBuffer[i].moveInt;
-                moveBuffer[i].moveInt = temp.moveInt;
-                return;
+                stats.deltaPruned++;
+                continue;
             }
         }
-    }
 
+        if (!isLegal(moveBuffer[i], masks))
+            continue;
 
-    if (nextMove) 
-    {
-        best = blackHeuristics[moveBuffer[i].getFrom()][moveBuffer[i].getTosq()];
-        j = i;
-        for (k = i + 1; k < moveBufLen[ply+1]; k++)
-        {
-            if (blackHeuristics[moveBuffer[k].getFrom()][moveBuffer[k].getTosq()] > best)
-            {
-                best = blackHeuristics[moveBuffer[k].getFrom()][moveBuffer[k].getTosq()];
-                j = k;                  
-            }
-        }
-        if (j > i)
-        {
-            temp.moveInt = moveBuffer[j].moveInt;
-            moveBuffer[j].moveInt = moveBuffer[i].moveInt;
-            moveBuffer[i].moveInt = temp.moveInt;
-        }
-    }
-    else
-    {
-        best = whiteHeuristics[moveBuffer[i].getFrom()][moveBuffer[i].getTosq()];
-        j = i;
-        for (k = i + 1; k < moveBufLen[ply+1]; k++)
-        {
-            if (whiteHeuristics[moveBuffer[k].getFrom()][moveBuffer[k].getTosq()] > best)
-            {
-                best = whiteHeuristics[moveBuffer[k].getFrom()][moveBuffer[k].getTosq()];
-                j = k;                  
-            }
-        }
-        if (j > i)
+        makeMove(moveBuffer[i]);
+        val = -qsearch(ply+1, -beta, -alpha);
+        unmakeMove(moveBuffer[i]);
+
+        if (val >= beta)
+            return beta;
+
+        if (val > alpha)
         {
-            temp.moveInt = moveBuffer[j].moveInt;
-            moveBuffer[j].moveInt = moveBuffer[i].moveInt;
-            moveBuffer[i].moveInt = temp.moveInt;
+            alpha = val;
+            updatePV(ply, moveBuffer[i]);
         }
     }
+
+    return alpha;
 }
@@ -71,6 +71,14 @@ int uciLoop(void)
     cout << PROGRAM_NAME << " v" << PROGRAM_VERSION << endl << endl;
     cout << "id name " << PROGRAM_NAME << endl;
     cout << "id author " << PROGRAM_AUTHOR << endl;
+    cout << "option name Hash type spin default " << CACHE_DEFAULT_SIZE;
+    cout << " min " << CACHE_MIN_SIZE << " max " << CACHE_MAX_SIZE << endl;
+    cout << "option name HashFile type string default " << CACHE_FILE << endl;
+    cout << "option name SaveHash type button" << endl;
+    cout << "option name LoadHash type button" << endl;
+    cout << "option name HashReplace type combo default depth var depth var always" << endl;
+    cout << "option name Threads type spin default 1 min 1 max " << THREADS_MAX << endl;
+    cout << "option name MTDf type check default false" << endl;
     cout << "uciok" << endl;
 
 
@@ -110,6 +118,89 @@ int uciLoop(void)
         }
 
 
+        // setoption name Hash value N
+        //
+        // Resize the transposition table to N MB.
+        else if (cmd.find("setoption name Hash value") != string::npos)
+        {
+            long long mb;
+
+            if (toNumber(cmd.substr(cmd.find("value") + 6), CACHE_MIN_SIZE, CACHE_MAX_SIZE, mb))
+            {
+                cache.resize(mb);
+                cout << "info string Hash " << cache.sizeMB() << " MB in " << cache.backingName() << endl;
+            }
+            else
+            {
+                cout << "info string Invalid Hash value, it must be " << CACHE_MIN_SIZE;
+                cout << " to " << CACHE_MAX_SIZE << " MB" << endl;
+            }
+        }
+
+
+        // setoption name HashFile value FILE
+        //
+        // Select the file used by SaveHash and LoadHash.
+        else if (cmd.find("setoption name HashFile value") != string::npos)
+        {
+            cacheFile = cmd.substr(cmd.find("value") + 6);
+        }
+
+
+        // setoption name SaveHash
+        //
+        // Save the transposition table to the hash file.
+        else if (cmd.find("setoption name SaveHash") != string::npos)
+        {
+            cache.save(cacheFile, KEY.seed);
+        }
+
+
+        // setoption name LoadHash
+        //
+        // Map the transposition table saved in the hash file into memory.
+        else if (cmd.find("setoption name LoadHash") != string::npos)
+        {
+            cache.load(cacheFile, KEY.seed);
+        }
+
+
+        // setoption name Threads value N
+        //
+        // Search with N threads (Lazy SMP).
+        else if (cmd.find("setoption name Threads value") != string::npos)
+        {
+            long long n;
+
+            if (toNumber(cmd.substr(cmd.find("value") + 6), 1, THREADS_MAX, n))
+            {
+                searchThreads = n;
+                cache.setThreads(n);
+            }
+        }
+
+
+        // setoption name HashReplace value depth|always
+        //
+        // Select the replacement policy of the transposition table.
+        else if (cmd.find("setoption name HashReplace value") != string::npos)
+        {
+            if (cmd.find("always") != string::npos)
+                cache.setPolicy(TT_REPLACE_ALWAYS);
+            else
+                cache.setPolicy(TT_REPLACE_DEPTH);
+        }
+
+
+        // setoption name MTDf value true|false
+        //
+        // Search the root with MTD(f) instead of PVS.
+        else if (cmd.find("setoption name MTDf value") != string::npos)
+        {
+            MTDF = (cmd.find("true") != string::npos);
+        }
+
+
         // go + parameters
         else if (cmd.find("go") != string::npos)
         {
@@ -428,6 +519,14 @@ int uciLoop(void)
 
             cout << "id name " << PROGRAM_NAME << endl;
             cout << "id author " << PROGRAM_AUTHOR << endl;
+            cout << "option name Hash type spin default " << CACHE_DEFAULT_SIZE;
+            cout << " min " << CACHE_MIN_SIZE << " max " << CACHE_MAX_SIZE << endl;
+            cout << "option name HashFile type string default " << CACHE_FILE << endl;
+            cout << "option name SaveHash type button" << endl;
+            cout << "option name LoadHash type button" << endl;
+            cout << "option name HashReplace type combo default depth var depth var always" << endl;
+            cout << "option name Threads type spin default 1 min 1 max " << THREADS_MAX << endl;
+            cout << "option name MTDf type check default false" << endl;
             cout << "uciok" << endl;
         }
 